@@ -10,6 +10,8 @@ set SDL_LIB=%SDL2%\lib\%TARGET%
 
 set CommonCompilerFlags=/Zi /Od /EHsc /nologo /FC /I%SDL_INC% 
 
+set BenchCompilerFlags=/Zi /O2 /EHsc /nologo /FC /I%SDL_INC% /DSNAKE_BENCH_RENDER
+
 set CommonLinkerFlags=/DEBUG /LIBPATH:%SDL_LIB% SDL2.lib SDL2main.lib
 
 if not exist bin (
@@ -22,6 +24,8 @@ if not exist SDL2.dll (
 )
 
 cl %CommonCompilerFlags% ..\src\main.cpp /link /subsystem:windows %CommonLinkerFlags% /out:%EXE_NAME%.exe
+cl %CommonCompilerFlags% ..\src\headless_main.cpp /link /subsystem:console /out:%EXE_NAME%_headless.exe
+cl %BenchCompilerFlags% ..\src\bench_main.cpp /link /subsystem:console %CommonLinkerFlags% /out:%EXE_NAME%_bench.exe
 popd
 echo Done
 
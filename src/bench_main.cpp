@@ -0,0 +1,28 @@
+//Entry point for the benchmarks. The render benchmarks are only built with
+//SNAKE_BENCH_RENDER defined, everything else doesn't need SDL.
+#include "snake.h"
+#include "snake_random.cpp"
+#include "snake_stats.cpp"
+#include "snake_trace.cpp"
+#include "snake_replay.cpp"
+#include "snake_neighbors.cpp"
+#include "snake_board.cpp"
+#include "snake_astar.cpp"
+#include "snake_jps.cpp"
+#include "snake_dstar.cpp"
+#include "snake_hamilton.cpp"
+#include "snake_bfs.cpp"
+#include "snake_game.cpp"
+#include "snake_headless.cpp"
+
+#ifdef SNAKE_BENCH_RENDER
+#include <SDL2/SDL.h>
+#include "snake_render.cpp"
+#endif
+
+#include "snake_bench.cpp"
+
+i32
+main(i32 argc, char **argv) {
+    return bench_main(argc, argv);
+}
@@ -0,0 +1,20 @@
+//Entry point for the headless build, doesn't include or link SDL.
+#include "snake.h"
+#include "snake_random.cpp"
+#include "snake_stats.cpp"
+#include "snake_trace.cpp"
+#include "snake_replay.cpp"
+#include "snake_neighbors.cpp"
+#include "snake_board.cpp"
+#include "snake_astar.cpp"
+#include "snake_jps.cpp"
+#include "snake_dstar.cpp"
+#include "snake_hamilton.cpp"
+#include "snake_bfs.cpp"
+#include "snake_game.cpp"
+#include "snake_headless.cpp"
+
+i32
+main(i32 argc, char **argv) {
+    return headless_main(argc, argv);
+}
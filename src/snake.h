@@ -0,0 +1,363 @@
+#ifndef SNAKE_H
+#define SNAKE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <atomic>
+
+#include <assert.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#if 0
+#include <windows.h>
+#else
+#define max(a, b)  (((a) > (b)) ? (a) : (b))
+#define min(a, b)  (((a) < (b)) ? (a) : (b))
+#endif
+
+#include <stdint.h>
+typedef int8_t i8;
+typedef int16_t i16;
+typedef int32_t i32;
+typedef int64_t i64;
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef float f32;
+typedef double f64;
+
+typedef i8 b8;
+typedef i16 b16;
+typedef i32 b32;
+typedef i64 b64;
+
+//Hot path counters (HotPathStats), off unless built with -DSNAKE_STATS=1.
+//Everything counted goes through SNAKE_STAT so that none of it is left when
+//they are off.
+#ifndef SNAKE_STATS
+#define SNAKE_STATS 0
+#endif
+
+#if SNAKE_STATS
+#define SNAKE_STAT(statement) statement
+#else
+#define SNAKE_STAT(statement)
+#endif
+
+struct Vec2 {
+    i32 x;
+    i32 y;
+};
+
+struct AstarScore {
+    i32 G;
+    i32 H;
+};
+
+struct AstarCell {
+    Vec2 position;
+    AstarScore score;
+    AstarCell* previous;
+    i32 heap_index;
+};
+
+//Work a search did since record_plan_stats last took it, only counted with
+//SNAKE_STATS. Searches without a heap count what they would have pushed and
+//popped.
+struct SearchCounts {
+    i64 push_count;
+    i64 pop_count;
+    i64 decrease_key_count;
+};
+
+//NOTE: Indexed binary min-heap keyed on f-score. Every cell remembers its slot
+//      in the heap so its key can be decreased without searching for it.
+struct AstarOpenHeap {
+    AstarCell** cells;
+    i32 count;
+    i32 capacity;
+#if SNAKE_STATS
+    SearchCounts counts; //A*, JPS and the fallbacks that use them
+#endif
+};
+
+inline Vec2
+operator+(const Vec2& lhs, const Vec2& rhs) {
+    return { lhs.x + rhs.x, lhs.y + lhs.y };
+}
+
+inline Vec2&
+operator+=(Vec2& lhs, const Vec2& rhs) {
+    Vec2 result;
+    result.x = lhs.x + rhs.x;
+    result.y = lhs.y + rhs.y;
+    lhs = result;
+    return lhs;
+}
+
+inline bool
+operator==(const Vec2& lhs, const Vec2& rhs) {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+inline bool
+operator!=(const Vec2& lhs, const Vec2& rhs) {
+    return !(lhs == rhs);
+}
+
+template<typename T> inline b32
+contains(std::vector<T>* vec, T val) {
+    return std::find(vec->begin(), vec->end(), val) != vec->end();
+}
+
+enum AstarNodeState {
+    ASTAR_NODE_UNSEEN,
+    ASTAR_NODE_OPEN,
+    ASTAR_NODE_CLOSED,
+};
+
+struct AstarNodeIndexEntry {
+    u32 generation;
+    i32 slot; //Index into the cell pool of the current search
+    u32 state;
+};
+
+//NOTE: Dense grid_width*grid_height lookup from a cell to its search node.
+//      An entry only counts if its generation matches the index generation,
+//      so starting a new search is just a counter bump instead of a clear.
+struct AstarNodeIndex {
+    AstarNodeIndexEntry* entries;
+    i32 count;
+    u32 generation;
+};
+
+//NOTE: All memory a planning call needs, sized once for the board so that
+//      steady state planning does no heap allocations.
+struct PathfinderWorkspace {
+    i32 max_count;
+    AstarCell* cells;
+    AstarOpenHeap open_set;
+    AstarNodeIndex node_index;
+    Vec2* path; //Output of the last search, start position first
+    i32 path_count;
+    //Per cell, the step at which the snake's body moves off it. Only read
+    //for occupied cells and only by the time-aware search.
+    i32* release_steps;
+};
+
+#define OCCUPANCY_CHANGE_CAPACITY 64
+
+//NOTE: One bit per grid cell, set while a snake segment covers the cell.
+//      Bit index is y*grid_width + x. The cells that are not set are also kept
+//      in a dense array (swap-removed on occupy) so a random free cell can be
+//      picked in O(1) no matter how full the board is.
+struct Occupancy {
+    u64* words;
+    i32 word_count;
+    i32 grid_width;
+    i32 grid_height;
+    i32* free_cells;
+    i32* free_slots; //Cell index -> slot in free_cells, only valid for free cells
+    i32 free_count;
+    //Cells that changed since the last clear_occupancy_changes, for planners
+    //that keep state between ticks. Too many changes just set the flag.
+    i32 changed_cells[OCCUPANCY_CHANGE_CAPACITY];
+    i32 changed_count;
+    b32 changes_overflowed;
+};
+
+//NOTE: Scratch bitboards for flood fills over the grid, same bit layout as
+//      Occupancy. A fill step moves every reached cell to its four neighbors
+//      at once with whole word shifts. Every board has padding words of
+//      zeroes on both sides so the shifts never have to bounds check.
+struct FloodFill {
+    i32 grid_width;
+    i32 grid_height;
+    i32 word_count;
+    i32 padding; //Words before and after each board
+    u64* not_first_column; //Cells with x > 0
+    u64* not_last_column;  //Cells with x < grid_width-1
+    u64* grid_cells;       //Every cell on the grid, clears the bits past the last cell
+    u64* passable;
+    u64* reached;
+    u64* frontier;
+    u64* next;
+    i32* distances; //Only valid for cells set in reached after a distance fill
+#if SNAKE_STATS
+    SearchCounts counts; //Only the BFS planner counts
+#endif
+};
+
+struct DstarKey {
+    i32 k1;
+    i32 k2;
+};
+
+struct DstarCell {
+    i32 g;
+    i32 rhs;
+    i32 heap_index; //-1 when not in the queue
+    DstarKey key;   //Key the cell was queued with
+    b32 blocked;
+};
+
+//NOTE: Search state of the incremental planner, kept from tick to tick.
+struct DstarLite {
+    i32 grid_width;
+    i32 grid_height;
+    DstarCell* cells;
+    i32* heap;
+    i32 heap_count;
+    i32 km;
+    Vec2 start;
+    Vec2 goal;
+    i32 goal_index;
+    b32 initialized;
+#if SNAKE_STATS
+    SearchCounts counts;
+#endif
+};
+
+enum Direction {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT,
+};
+
+struct Rng {
+    u64 state;
+    u64 increment;
+};
+
+enum GameOverCause {
+    GAME_OVER_NONE,
+    GAME_OVER_WALL,
+    GAME_OVER_SELF,
+    GAME_OVER_BOARD_FULL,
+    GAME_OVER_STARVED, //Set by whoever drives the game, game_loop never starves
+
+    GAME_OVER_CAUSE_COUNT
+};
+
+enum Planner {
+    PLANNER_ASTAR,
+    PLANNER_JPS,
+    PLANNER_DSTAR_LITE,
+    PLANNER_TIMED_ASTAR,
+    PLANNER_HAMILTON,
+    PLANNER_BFS,
+
+    PLANNER_COUNT
+};
+
+struct HamiltonCycle {
+    i32* order; //Cell index -> position along the cycle
+    i32* cells; //Position along the cycle -> cell index
+    i32 length;
+};
+
+//Everything about a game that can be set from the command line.
+struct GameConfig {
+    i32 grid_width;
+    i32 grid_height;
+    f64 start_frame_time; //Seconds per tick at the start of a game
+    f64 min_frame_time;
+    f64 speed_up_rate;    //frame_time is multiplied by this for every fruit
+    i32 planner;
+    b32 tail_safety; //Only take paths that leave a way back to the tail
+};
+
+#define REPLAY_RUN_MOVES 4096    //Moves buffered before they go out as one record
+#define REPLAY_BUFFER_SIZE 65536 //Bytes buffered before they are written
+
+//NOTE: Streams a replay to a file as the game goes, see snake_replay.cpp for
+//      the format.
+struct ReplayWriter {
+    FILE* file;
+    i32 grid_width;
+    u8 buffer[REPLAY_BUFFER_SIZE];
+    i32 buffer_count;
+    u8 moves[REPLAY_RUN_MOVES / 4]; //2 bits per move, first move in the lowest bits
+    i32 move_count;
+};
+
+struct ReplayHeader {
+    u64 seed;
+    u32 flags; //REPLAY_SEED_PER_GAME
+    GameConfig game;
+};
+
+struct HotPathStats {
+    i64 ticks;
+    i64 plans;           //Plans to the fruit, not counting the ticks that used the cached path or chased the tail
+    i64 nodes_expanded;  //Taken off the open set
+    i64 nodes_pushed;    //Put on the open set
+    i64 heap_operations; //Pushes, pops and decreased keys
+    i64 path_length;     //Summed over plans
+    i64 plan_ns;         //Finding the next cell, including the path cache
+    i64 move_ns;         //Moving, collisions and the fruit
+    i64 frames;
+    i64 render_ns;
+};
+
+struct Game {
+    f64 start_frame_time;
+    f64 min_frame_time;
+    f64 speed_up_rate;
+    i32 grid_width;
+    i32 grid_height;
+    f64 frame_time;
+    i32 snake_cell_count;
+    i32 max_cell_count;
+    i32 input;
+    Vec2* positions; //Ring buffer of max_cell_count segments, see snake_segment
+    i32 head_index;
+    Occupancy occupancy;
+    i32 planner;
+    PathfinderWorkspace pathfinder;
+    DstarLite dstar; //Only allocated when planner is PLANNER_DSTAR_LITE
+    i32 path_step; //Next cell to follow in pathfinder.path, 0 when nothing is cached
+    i64 path_cache_hits; //Ticks that followed the cached path since the last reset
+    i64 path_cache_misses; //Ticks that had to run the planner
+    b32 tail_safety;
+    FloodFill flood_fill;
+    i64 tail_chases; //Plans to the fruit that were rejected as unsafe since the last reset
+#if SNAKE_STATS
+    HotPathStats stats; //Not cleared by a reset, whoever reports them clears them
+#endif
+    ReplayWriter* replay; //Every move and fruit is recorded to it if set
+    i32 tail_chase_ticks; //Ticks in a row spent chasing the tail
+    HamiltonCycle cycle; //Only built when planner is PLANNER_HAMILTON
+    Vec2 shortcut_fruit_pos; //Fruit the hamilton planner last planned for, -1 to plan again
+    Vec2 fruit_pos;
+    i32 direction;
+    b32 collided;
+    i32 game_over_cause;
+    u32 flash_count;
+    u32 flash_counter;
+    u64 seed; //Last seed passed to seed_game
+    Rng rng;
+    i32 score; //Fruits eaten since the last reset
+    i32 ticks_since_fruit;
+};
+
+#endif
@@ -0,0 +1,321 @@
+inline i32
+f_score(AstarScore score) {
+    return score.G + score.H;
+}
+
+//Returns true if a should be popped before b.
+//Ties on F are broken towards the lower H, i.e. the cell closer to the goal.
+inline b32
+astar_heap_less(AstarCell* a, AstarCell* b) {
+    i32 a_F = f_score(a->score);
+    i32 b_F = f_score(b->score);
+    if(a_F != b_F) {
+        return a_F < b_F;
+    }
+    return a->score.H < b->score.H;
+}
+
+inline void
+astar_heap_place(AstarOpenHeap* heap, i32 index, AstarCell* cell) {
+    heap->cells[index] = cell;
+    cell->heap_index = index;
+}
+
+static void
+astar_heap_sift_up(AstarOpenHeap* heap, i32 index) {
+    AstarCell* cell = heap->cells[index];
+    while(index > 0) {
+        i32 parent = (index - 1) / 2;
+        if(!astar_heap_less(cell, heap->cells[parent])) {
+            break;
+        }
+        astar_heap_place(heap, index, heap->cells[parent]);
+        index = parent;
+    }
+    astar_heap_place(heap, index, cell);
+}
+
+static void
+astar_heap_sift_down(AstarOpenHeap* heap, i32 index) {
+    AstarCell* cell = heap->cells[index];
+    for(;;) {
+        i32 child = index*2 + 1;
+        if(child >= heap->count) {
+            break;
+        }
+        if(child + 1 < heap->count && astar_heap_less(heap->cells[child + 1], heap->cells[child])) {
+            ++child;
+        }
+        if(!astar_heap_less(heap->cells[child], cell)) {
+            break;
+        }
+        astar_heap_place(heap, index, heap->cells[child]);
+        index = child;
+    }
+    astar_heap_place(heap, index, cell);
+}
+
+static void
+astar_heap_push(AstarOpenHeap* heap, AstarCell* cell) {
+    assert(heap->count < heap->capacity);
+    SNAKE_STAT(++heap->counts.push_count);
+    i32 index = heap->count++;
+    astar_heap_place(heap, index, cell);
+    astar_heap_sift_up(heap, index);
+}
+
+static AstarCell*
+astar_heap_pop(AstarOpenHeap* heap) {
+    assert(heap->count > 0);
+    SNAKE_STAT(++heap->counts.pop_count);
+    AstarCell* result = heap->cells[0];
+    --heap->count;
+    if(heap->count > 0) {
+        astar_heap_place(heap, 0, heap->cells[heap->count]);
+        astar_heap_sift_down(heap, 0);
+    }
+    result->heap_index = -1;
+    return result;
+}
+
+//Call after lowering the score of a cell that is already in the heap.
+inline void
+astar_heap_decrease_key(AstarOpenHeap* heap, AstarCell* cell) {
+    assert(cell->heap_index >= 0 && cell->heap_index < heap->count);
+    SNAKE_STAT(++heap->counts.decrease_key_count);
+    astar_heap_sift_up(heap, cell->heap_index);
+}
+
+static void
+astar_node_index_begin_search(AstarNodeIndex* index) {
+    ++index->generation;
+    if(index->generation == 0) {
+        //Wrapped around, stale entries could look current again
+        memset(index->entries, 0, index->count*sizeof(AstarNodeIndexEntry));
+        index->generation = 1;
+    }
+}
+
+inline AstarNodeIndexEntry*
+astar_node_index_get(AstarNodeIndex* index, Vec2 pos, i32 grid_width) {
+    AstarNodeIndexEntry* entry = &index->entries[pos.y*grid_width + pos.x];
+    if(entry->generation != index->generation) {
+        entry->generation = index->generation;
+        entry->slot = -1;
+        entry->state = ASTAR_NODE_UNSEEN;
+    }
+    return entry;
+}
+
+inline i32
+astar_heuristic(Vec2 pos, Vec2 goal) {
+    return abs(pos.x - goal.x) + abs(pos.y - goal.y);
+}
+
+//NOTE: The searches are written against a grid dimensions policy. FixedGridDims
+//      makes the width and height compile time constants, so cell index math
+//      and bounds checks fold into immediates. DynamicGridDims reads them
+//      from the occupancy like before and works for any grid.
+template<i32 Width, i32 Height>
+struct FixedGridDims {
+    inline i32 width() const { return Width; }
+    inline i32 height() const { return Height; }
+};
+
+struct DynamicGridDims {
+    i32 grid_width;
+    i32 grid_height;
+    inline i32 width() const { return grid_width; }
+    inline i32 height() const { return grid_height; }
+};
+
+//Fixed sizes check the neighbors inline, the compiler sees through all of it.
+template<typename Dims>
+inline u32
+walkable_adjacent_mask(Dims dims, Vec2 pos, Occupancy* occupancy) {
+    i32 cell = pos.y*dims.width() + pos.x;
+    i32 cells[4] = { cell + dims.width(), cell - 1, cell + 1, cell - dims.width() };
+    u32 on_grid = adjacent_cells_on_grid(pos, dims.width(), dims.height());
+    u32 occupied = 0;
+    for(i32 i = 0; i < 4; i++) {
+        //Off grid candidates look at cell 0 instead of branching
+        occupied |= occupancy_bit(occupancy, ((on_grid >> i) & 1) ? cells[i] : 0) << i;
+    }
+    return on_grid & ~occupied;
+}
+
+//Any other size goes through the version picked for this CPU.
+inline u32
+walkable_adjacent_mask(DynamicGridDims, Vec2 pos, Occupancy* occupancy) {
+    return find_walkable_adjacent_cells(pos, occupancy);
+}
+
+//Like find_walkable_adjacent_cells, but for a move that arrives on step
+//arrival_step. An occupied cell counts as walkable once its body segment is
+//gone by then.
+template<typename Dims>
+static u32
+find_adjacent_cells_free_at(Dims dims, Vec2 pos, Occupancy* occupancy, i32* release_steps, i32 arrival_step) {
+    u32 mask = walkable_adjacent_mask(dims, pos, occupancy);
+    u32 occupied = adjacent_cells_on_grid(pos, dims.width(), dims.height()) & ~mask;
+    for(; occupied; occupied &= occupied - 1) {
+        i32 i = lowest_set_bit(occupied);
+        Vec2 adjacent = pos;
+        adjacent += adjacent_offsets[i];
+        if(release_steps[adjacent.y*dims.width() + adjacent.x] <= arrival_step) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+}
+
+static void
+init_pathfinder_workspace(PathfinderWorkspace* workspace, i32 max_count) {
+    workspace->max_count = max_count;
+    workspace->cells = (AstarCell*)calloc(max_count, sizeof(AstarCell));
+    workspace->open_set.cells = (AstarCell**)calloc(max_count, sizeof(AstarCell*));
+    workspace->open_set.count = 0;
+    workspace->open_set.capacity = max_count;
+    SNAKE_STAT(clear_search_counts(&workspace->open_set.counts));
+    workspace->node_index.entries = (AstarNodeIndexEntry*)calloc(max_count, sizeof(AstarNodeIndexEntry));
+    workspace->node_index.count = max_count;
+    workspace->node_index.generation = 0;
+    workspace->path = (Vec2*)calloc(max_count, sizeof(Vec2));
+    workspace->path_count = 0;
+    workspace->release_steps = (i32*)calloc(max_count, sizeof(i32));
+}
+
+static void
+free_pathfinder_workspace(PathfinderWorkspace* workspace) {
+    free(workspace->cells);
+    free(workspace->open_set.cells);
+    free(workspace->node_index.entries);
+    free(workspace->path);
+    free(workspace->release_steps);
+}
+
+static i32
+astar_reconstruct_path(AstarCell* goal, Vec2* path) {
+    i32 count = 0;
+    for(AstarCell* current = goal; current != 0; current = current->previous) {
+        ++count;
+    }
+
+    i32 index = count;
+    for(AstarCell* current = goal; current != 0; current = current->previous) {
+        path[--index] = current->position;
+    }
+    return count;
+}
+
+//Search state stays in the workspace rather than on the stack even for the
+//fixed sizes, a 128x128 search needs over half a megabyte for its cells and
+//heap which is more than a worker thread's stack should take.
+template<typename Dims>
+static i32
+find_path_with_astar_on(Dims dims, PathfinderWorkspace* workspace, Vec2 start, Vec2 goal,
+      Occupancy* occupancy, b32 timed)
+{
+    i32 grid_width = dims.width();
+    assert(grid_width == occupancy->grid_width && dims.height() == occupancy->grid_height);
+    assert(workspace->max_count == grid_width*dims.height());
+    AstarCell* cells = workspace->cells;
+    i32 cell_counter = 0;
+
+    AstarOpenHeap* open_set = &workspace->open_set;
+    open_set->count = 0;
+
+    AstarNodeIndex* node_index = &workspace->node_index;
+    astar_node_index_begin_search(node_index);
+
+    AstarNodeIndexEntry* start_entry = astar_node_index_get(node_index, start, grid_width);
+    start_entry->slot = cell_counter;
+    start_entry->state = ASTAR_NODE_OPEN;
+
+    AstarCell* current_cell = &cells[cell_counter++];
+    current_cell->position = start;
+    current_cell->score.G = 0;
+    current_cell->score.H = astar_heuristic(start, goal);
+    current_cell->previous = 0;
+
+    astar_heap_push(open_set, current_cell);
+
+    do {
+        current_cell = astar_heap_pop(open_set);
+        astar_node_index_get(node_index, current_cell->position, grid_width)->state = ASTAR_NODE_CLOSED;
+
+        if(current_cell->position == goal) {
+            //Found path
+            break;
+        }
+
+        u32 adjacent_cells;
+        if(timed) {
+            adjacent_cells = find_adjacent_cells_free_at(dims, current_cell->position, occupancy,
+                                                         workspace->release_steps, current_cell->score.G+1);
+        } else {
+            adjacent_cells = walkable_adjacent_mask(dims, current_cell->position, occupancy);
+        }
+
+        for(; adjacent_cells; adjacent_cells &= adjacent_cells - 1) {
+            Vec2 pos = current_cell->position;
+            pos += adjacent_offsets[lowest_set_bit(adjacent_cells)];
+            AstarNodeIndexEntry* entry = astar_node_index_get(node_index, pos, grid_width);
+            if(entry->state == ASTAR_NODE_CLOSED) {
+                continue;
+            }
+
+            i32 G = current_cell->score.G+1;
+            if(entry->state == ASTAR_NODE_UNSEEN) {
+                entry->slot = cell_counter;
+                entry->state = ASTAR_NODE_OPEN;
+                AstarCell* cell = &cells[cell_counter++];
+                cell->position = pos;
+                cell->score.G = G;
+                cell->score.H = astar_heuristic(pos, goal);
+                cell->previous = current_cell;
+                astar_heap_push(open_set, cell);
+            } else {
+                AstarCell* found_cell = &cells[entry->slot];
+                if(G < found_cell->score.G) {
+                    found_cell->previous = current_cell;
+                    found_cell->score.G = G;
+                    astar_heap_decrease_key(open_set, found_cell);
+                }
+            }
+        }
+
+    } while(open_set->count > 0);
+
+    workspace->path_count = astar_reconstruct_path(current_cell, workspace->path);
+    return workspace->path_count;
+}
+
+//Returns the number of positions written to workspace->path.
+//If the goal can't be reached the path leads to the last cell the search
+//expanded before the open set ran dry. That is some reachable cell, not
+//necessarily the one closest to the goal.
+//
+//With timed set, G doubles as the step a cell is reached on and body cells
+//open up once workspace->release_steps says they are vacated. Cells are
+//still closed on their first (earliest) arrival, so the search stays over
+//cells instead of (cell, step) pairs. That can miss a path that needs to
+//arrive somewhere later, but it never returns one that runs into the body.
+//
+//The common square sizes get a search specialized for them.
+static i32
+find_path_with_astar(PathfinderWorkspace* workspace, Vec2 start, Vec2 goal,
+      Occupancy* occupancy, b32 timed)
+{
+    if(occupancy->grid_width == occupancy->grid_height) {
+        switch(occupancy->grid_width) {
+            case 8:   return find_path_with_astar_on(FixedGridDims<8, 8>(), workspace, start, goal, occupancy, timed);
+            case 16:  return find_path_with_astar_on(FixedGridDims<16, 16>(), workspace, start, goal, occupancy, timed);
+            case 32:  return find_path_with_astar_on(FixedGridDims<32, 32>(), workspace, start, goal, occupancy, timed);
+            case 64:  return find_path_with_astar_on(FixedGridDims<64, 64>(), workspace, start, goal, occupancy, timed);
+            case 128: return find_path_with_astar_on(FixedGridDims<128, 128>(), workspace, start, goal, occupancy, timed);
+        }
+    }
+    DynamicGridDims dims = { occupancy->grid_width, occupancy->grid_height };
+    return find_path_with_astar_on(dims, workspace, start, goal, occupancy, timed);
+}
@@ -0,0 +1,418 @@
+//NOTE: Microbenchmarks for the pathfinder, whole games, fruit placement and,
+//      when built with SNAKE_BENCH_RENDER, rendering. Every case runs its
+//      warmup samples first and then the measured ones. A sample times
+//      ops_per_sample operations so the cases that take nanoseconds don't
+//      just measure the clock. The median and p99 are per operation.
+//
+//      The boards come from the seed alone, so two runs with the same seed
+//      measure the same work and their JSON output can be compared.
+
+struct BenchConfig {
+    i32 warmup;      //Samples run before measuring
+    i32 repetitions; //Samples measured
+    u64 seed;
+    const char* filter;    //Only cases whose name contains this run, 0 runs all
+    const char* json_path; //Results are also written there if set
+};
+
+struct BenchResult {
+    char name[64];
+    i32 samples;
+    i32 ops_per_sample;
+    f64 median_ns;
+    f64 p99_ns;
+    f64 mean_ns;
+    f64 min_ns;
+    f64 items_per_second; //Ticks per second for whole games, 0 otherwise
+};
+
+struct BenchRun {
+    BenchConfig* config;
+    std::vector<BenchResult> results;
+};
+
+//Runs one operation of a benchmark case. Returns the number of items it
+//processed, or 0 if the case doesn't count any.
+typedef i64 BenchOpProc(void* context);
+
+static void
+default_bench_config(BenchConfig* config) {
+    config->warmup = 10;
+    config->repetitions = 200;
+    config->seed = 1;
+    config->filter = 0;
+    config->json_path = 0;
+}
+
+static b32
+bench_selected(BenchRun* run, const char* name) {
+    return !run->config->filter || strstr(name, run->config->filter) != 0;
+}
+
+static void
+bench_measure(BenchRun* run, const char* name, BenchOpProc* op, void* context, i32 ops_per_sample) {
+    BenchConfig* config = run->config;
+    for(i32 sample = 0; sample < config->warmup; sample++) {
+        for(i32 i = 0; i < ops_per_sample; i++) {
+            op(context);
+        }
+    }
+
+    i32 sample_count = max(config->repetitions, 1);
+    std::vector<f64> samples(sample_count);
+    i64 items = 0;
+    i64 total_ns = 0;
+    for(i32 sample = 0; sample < sample_count; sample++) {
+        i64 start_ns = stats_get_ns();
+        for(i32 i = 0; i < ops_per_sample; i++) {
+            items += op(context);
+        }
+        i64 elapsed_ns = stats_get_ns() - start_ns;
+        total_ns += elapsed_ns;
+        samples[sample] = (f64)elapsed_ns / ops_per_sample;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    result.samples = sample_count;
+    result.ops_per_sample = ops_per_sample;
+    result.median_ns = (sample_count % 2) ? samples[sample_count/2] :
+                       (samples[sample_count/2 - 1] + samples[sample_count/2]) / 2;
+    result.p99_ns = samples[max((i32)ceil(0.99*sample_count) - 1, 0)];
+    result.mean_ns = (f64)total_ns / ((f64)sample_count*ops_per_sample);
+    result.min_ns = samples[0];
+    result.items_per_second = (items > 0 && total_ns > 0) ? (f64)items / (total_ns*1e-9) : 0;
+    run->results.push_back(result);
+
+    printf("%-28s median %12.1f ns  p99 %12.1f ns", result.name, result.median_ns, result.p99_ns);
+    if(result.items_per_second > 0) {
+        printf("  %12.0f items/s", result.items_per_second);
+    }
+    printf("\n");
+}
+
+//Occupies random cells until fill_percent of the board is taken.
+static void
+bench_fill_board(Occupancy* occupancy, Rng* rng, i32 fill_percent) {
+    i32 cell_count = occupancy->grid_width*occupancy->grid_height;
+    i32 target_count = (i32)((i64)cell_count*fill_percent / 100);
+    while(cell_count - occupancy->free_count < target_count) {
+        i32 cell = occupancy->free_cells[random_below(rng, occupancy->free_count)];
+        Vec2 pos = { cell % occupancy->grid_width, cell / occupancy->grid_width };
+        occupy_cell(occupancy, pos);
+    }
+}
+
+static Vec2
+bench_random_free_cell(Occupancy* occupancy, Rng* rng) {
+    i32 cell = occupancy->free_cells[random_below(rng, occupancy->free_count)];
+    Vec2 result = { cell % occupancy->grid_width, cell / occupancy->grid_width };
+    return result;
+}
+
+#define BENCH_ASTAR_QUERY_COUNT 64
+
+struct BenchAstarContext {
+    PathfinderWorkspace workspace;
+    Occupancy occupancy;
+    Vec2 starts[BENCH_ASTAR_QUERY_COUNT];
+    Vec2 goals[BENCH_ASTAR_QUERY_COUNT];
+    i32 next_query;
+};
+
+static i64
+bench_astar_op(void* context) {
+    BenchAstarContext* bench = (BenchAstarContext*)context;
+    i32 query = bench->next_query;
+    bench->next_query = (query + 1) % BENCH_ASTAR_QUERY_COUNT;
+    find_path_with_astar(&bench->workspace, bench->starts[query], bench->goals[query], &bench->occupancy, false);
+    return 0;
+}
+
+//Single A* queries between random free cells of boards with random
+//obstacles. Past about half full most goals can't be reached, those
+//queries explore everything the start can reach.
+static void
+bench_astar(BenchRun* run) {
+    static const i32 sizes[] = { 8, 16, 32, 48, 64, 128 };
+    static const i32 fill_percents[] = { 0, 25, 50 };
+    for(i32 size_index = 0; size_index < (i32)(sizeof(sizes)/sizeof(*sizes)); size_index++) {
+        for(i32 fill_index = 0; fill_index < (i32)(sizeof(fill_percents)/sizeof(*fill_percents)); fill_index++) {
+            i32 size = sizes[size_index];
+            i32 fill_percent = fill_percents[fill_index];
+            char name[64];
+            snprintf(name, sizeof(name), "astar/%dx%d/fill%d", size, size, fill_percent);
+            if(!bench_selected(run, name)) {
+                continue;
+            }
+
+            BenchAstarContext* bench = (BenchAstarContext*)calloc(1, sizeof(BenchAstarContext));
+            init_pathfinder_workspace(&bench->workspace, size*size);
+            init_occupancy(&bench->occupancy, size, size);
+            clear_occupancy(&bench->occupancy);
+            Rng rng;
+            seed_random(&rng, mix_seed(run->config->seed, (u64)(size*1000 + fill_percent)));
+            bench_fill_board(&bench->occupancy, &rng, fill_percent);
+            for(i32 i = 0; i < BENCH_ASTAR_QUERY_COUNT; i++) {
+                bench->starts[i] = bench_random_free_cell(&bench->occupancy, &rng);
+                bench->goals[i] = bench_random_free_cell(&bench->occupancy, &rng);
+            }
+
+            //Small boards answer in well under a microsecond
+            bench_measure(run, name, bench_astar_op, bench, max(4096 / (size*size), 1));
+
+            free_occupancy(&bench->occupancy);
+            free_pathfinder_workspace(&bench->workspace);
+            free(bench);
+        }
+    }
+}
+
+//Games per sample. Every sample plays the same seeds, so the samples only
+//differ by how fast the code ran and not by how long the games lasted.
+#define BENCH_GAME_SEEDS 4
+
+struct BenchGameContext {
+    Game game;
+    HeadlessStats stats;
+    i32 starvation_ticks;
+    u64 seed;
+    i32 next_game; //Index into the BENCH_GAME_SEEDS seeds
+};
+
+static i64
+bench_game_op(void* context) {
+    BenchGameContext* bench = (BenchGameContext*)context;
+    i64 start_ticks = bench->stats.ticks;
+    seed_game(&bench->game, mix_seed(bench->seed, (u64)bench->next_game));
+    bench->next_game = (bench->next_game + 1) % BENCH_GAME_SEEDS;
+    play_headless_game(&bench->game, bench->starvation_ticks, &bench->stats);
+    return bench->stats.ticks - start_ticks;
+}
+
+static void
+bench_game_case(BenchRun* run, i32 size, i32 planner) {
+    char name[64];
+    snprintf(name, sizeof(name), "game/%dx%d/%s", size, size, planner_names[planner]);
+    if(!bench_selected(run, name)) {
+        return;
+    }
+
+    HeadlessConfig config;
+    default_headless_config(&config);
+    config.game.grid_width = size;
+    config.game.grid_height = size;
+    config.game.planner = planner;
+
+    BenchGameContext* bench = new BenchGameContext;
+    init_game(&bench->game, &config.game);
+    init_headless_stats(&bench->stats, size*size);
+    bench->starvation_ticks = headless_starvation_ticks(&config);
+    bench->seed = run->config->seed;
+    bench->next_game = 0;
+
+    bench_measure(run, name, bench_game_op, bench, BENCH_GAME_SEEDS);
+
+    free_headless_stats(&bench->stats);
+    free_game(&bench->game);
+    delete bench;
+}
+
+//Whole games from reset to game over, the items are ticks. The times are per
+//game, averaged over the BENCH_GAME_SEEDS games of a sample.
+static void
+bench_games(BenchRun* run) {
+    bench_game_case(run, 8, PLANNER_ASTAR);
+    for(i32 planner = 0; planner < PLANNER_COUNT; planner++) {
+        bench_game_case(run, 16, planner);
+    }
+    bench_game_case(run, 32, PLANNER_ASTAR);
+}
+
+static i64
+bench_fruit_op(void* context) {
+    randomize_fruit_pos((Game*)context);
+    return 0;
+}
+
+//Fruit placement on a nearly full board.
+static void
+bench_fruit(BenchRun* run) {
+    static const i32 sizes[] = { 32, 128 };
+    static const i32 fill_percents[] = { 50, 90, 99 };
+    for(i32 size_index = 0; size_index < (i32)(sizeof(sizes)/sizeof(*sizes)); size_index++) {
+        for(i32 fill_index = 0; fill_index < (i32)(sizeof(fill_percents)/sizeof(*fill_percents)); fill_index++) {
+            i32 size = sizes[size_index];
+            i32 fill_percent = fill_percents[fill_index];
+            char name[64];
+            snprintf(name, sizeof(name), "fruit/%dx%d/fill%d", size, size, fill_percent);
+            if(!bench_selected(run, name)) {
+                continue;
+            }
+
+            GameConfig config;
+            default_game_config(&config);
+            config.grid_width = size;
+            config.grid_height = size;
+            Game* game = new Game;
+            init_game(game, &config);
+            seed_game(game, mix_seed(run->config->seed, (u64)(size*1000 + fill_percent)));
+            reset_state(game);
+            bench_fill_board(&game->occupancy, &game->rng, fill_percent);
+
+            bench_measure(run, name, bench_fruit_op, game, 256);
+
+            free_game(game);
+            delete game;
+        }
+    }
+}
+
+#ifdef SNAKE_BENCH_RENDER
+struct BenchRenderContext {
+    Game game;
+    Rendering rendering;
+    SDL_Surface* surface;
+    SDL_Renderer* renderer;
+};
+
+static i64
+bench_render_op(void* context) {
+    BenchRenderContext* bench = (BenchRenderContext*)context;
+    render_loop(bench->renderer, &bench->rendering, &bench->game);
+    return 0;
+}
+
+//One frame of a game some way in, drawn by the software renderer into a
+//surface the size of the default window. Needs no display, so it measures
+//the drawing and not the driver or the present.
+static void
+bench_render(BenchRun* run) {
+    static const i32 sizes[] = { 16, 64, 256 };
+    for(i32 size_index = 0; size_index < (i32)(sizeof(sizes)/sizeof(*sizes)); size_index++) {
+        i32 size = sizes[size_index];
+        GameConfig config;
+        default_game_config(&config);
+        config.grid_width = size;
+        config.grid_height = size;
+        i32 width, height;
+        default_window_size(&config, &width, &height);
+
+        BenchRenderContext* bench = new BenchRenderContext;
+        init_game(&bench->game, &config);
+        init_rendering(&bench->rendering, &bench->game, width, height);
+
+        char name[64];
+        snprintf(name, sizeof(name), "render/%dx%d/%s", size, size,
+                 bench->rendering.pixel_mode ? "pixels" : "rects");
+        if(bench_selected(run, name)) {
+            seed_game(&bench->game, run->config->seed);
+            reset_state(&bench->game);
+            for(i32 tick = 0; tick < size*size/2 && !bench->game.collided; tick++) {
+                game_loop(&bench->game);
+            }
+
+            bench->surface = SDL_CreateRGBSurface(0, width, height, 32, 0, 0, 0, 0);
+            bench->renderer = SDL_CreateSoftwareRenderer(bench->surface);
+            init_renderer(bench->renderer, &bench->rendering, &bench->game);
+
+            bench_measure(run, name, bench_render_op, bench, 1);
+
+            SDL_DestroyRenderer(bench->renderer);
+            SDL_FreeSurface(bench->surface);
+        }
+
+        free(bench->rendering.rects);
+        free(bench->rendering.pixels);
+        free_game(&bench->game);
+        delete bench;
+    }
+}
+#endif
+
+static b32
+write_bench_json(BenchRun* run, const char* path) {
+    FILE* file = fopen(path, "w");
+    if(!file) {
+        fprintf(stderr, "Can't write %s\n", path);
+        return false;
+    }
+
+    BenchConfig* config = run->config;
+    fprintf(file, "{\n");
+    fprintf(file, "  \"seed\": %llu,\n", (unsigned long long)config->seed);
+    fprintf(file, "  \"warmup\": %d,\n", config->warmup);
+    fprintf(file, "  \"repetitions\": %d,\n", config->repetitions);
+    fprintf(file, "  \"neighbors\": \"%s\",\n", walkable_adjacent_mask_version.name);
+    fprintf(file, "  \"flood_fill\": \"%s\",\n", flood_fill_expand_version.name);
+    fprintf(file, "  \"results\": [\n");
+    for(size_t i = 0; i < run->results.size(); i++) {
+        BenchResult* result = &run->results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"samples\": %d, \"ops_per_sample\": %d, "
+                      "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"mean_ns\": %.1f, \"min_ns\": %.1f, "
+                      "\"items_per_second\": %.1f}%s\n",
+                result->name, result->samples, result->ops_per_sample,
+                result->median_ns, result->p99_ns, result->mean_ns, result->min_ns,
+                result->items_per_second, i + 1 < run->results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+    fclose(file);
+    return true;
+}
+
+static b32
+parse_bench_args(i32 argc, char** argv, BenchConfig* config) {
+    for(i32 i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : 0;
+        if(strcmp(arg, "--warmup") == 0 && value) {
+            config->warmup = max(atoi(value), 0);
+            ++i;
+        } else if(strcmp(arg, "--repetitions") == 0 && value) {
+            config->repetitions = max(atoi(value), 1);
+            ++i;
+        } else if(strcmp(arg, "--seed") == 0 && value) {
+            config->seed = strtoull(value, 0, 10);
+            ++i;
+        } else if(strcmp(arg, "--filter") == 0 && value) {
+            config->filter = value;
+            ++i;
+        } else if(strcmp(arg, "--json") == 0 && value) {
+            config->json_path = value;
+            ++i;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+static i32
+bench_main(i32 argc, char** argv) {
+    BenchConfig config;
+    default_bench_config(&config);
+    if(!parse_bench_args(argc, argv, &config)) {
+        fprintf(stderr, "Usage: %s [--warmup N] [--repetitions N] [--seed N] [--filter TEXT] [--json FILE]\n", argv[0]);
+        return 1;
+    }
+
+    BenchRun run;
+    run.config = &config;
+    printf("seed %llu, %d warmup and %d measured samples, neighbors: %s, flood fill: %s\n",
+           (unsigned long long)config.seed, config.warmup, config.repetitions,
+           walkable_adjacent_mask_version.name, flood_fill_expand_version.name);
+    bench_astar(&run);
+    bench_games(&run);
+    bench_fruit(&run);
+#ifdef SNAKE_BENCH_RENDER
+    bench_render(&run);
+#endif
+
+    if(config.json_path && !write_bench_json(&run, config.json_path)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+//NOTE: Breadth first search over bitboards. The search grows outwards one
+//      distance at a time: the whole frontier is expanded with
+//      flood_fill_expand_words, so a step costs a pass over the words the
+//      frontier spans no matter how many cells are on it. Each newly reached
+//      cell gets its distance written, and paths just walk downhill on those
+//      distances.
+
+//Grows distances from from_cell over fill->passable until to_cell is
+//reached (pass -1 to fill everything reachable). Returns the distance of the
+//last layer reached, which is left in fill->frontier.
+static i32
+bfs_fill_distances(FloodFill* fill, i32 from_cell, i32 to_cell) {
+    i32 word_count = fill->word_count;
+    u64* passable = fill->passable;
+    u64* reached = fill->reached;
+
+    //Both frontier boards are kept zero outside the words the frontier spans
+    memset(reached, 0, word_count*sizeof(u64));
+    memset(fill->frontier, 0, word_count*sizeof(u64));
+    memset(fill->next, 0, word_count*sizeof(u64));
+    reached[from_cell >> 6] |= (u64)1 << (from_cell & 63);
+    fill->frontier[from_cell >> 6] |= (u64)1 << (from_cell & 63);
+    fill->distances[from_cell] = 0;
+    i32 frontier_first = from_cell >> 6;
+    i32 frontier_last = frontier_first;
+
+    i32 distance = 0;
+    SNAKE_STAT(i64 layer_count = 1);
+    while(to_cell < 0 || !(reached[to_cell >> 6] & ((u64)1 << (to_cell & 63)))) {
+        u64* frontier = fill->frontier;
+        u64* next = fill->next;
+        i32 first = frontier_first;
+        i32 last = frontier_last;
+        flood_fill_spread_words(fill, &first, &last);
+        flood_fill_expand_words(fill, frontier, next, first, last);
+        //Every cell of the layer is expanded, every new one pushed
+        SNAKE_STAT(fill->counts.pop_count += layer_count);
+        SNAKE_STAT(layer_count = 0);
+
+        i32 next_first = word_count;
+        i32 next_last = -1;
+        for(i32 i = first; i <= last; i++) {
+            u64 word = next[i] & passable[i] & ~reached[i];
+            reached[i] |= word;
+            next[i] = word;
+            if(word) {
+                next_first = min(next_first, i);
+                next_last = i;
+                for(; word; word &= word - 1) {
+                    fill->distances[i*64 + lowest_set_bit(word)] = distance + 1;
+                    SNAKE_STAT(++layer_count);
+                }
+            }
+        }
+        SNAKE_STAT(fill->counts.push_count += layer_count);
+        if(next_last < 0) {
+            //Nothing new, keep the last layer in frontier
+            memset(next + first, 0, (last - first + 1)*sizeof(u64));
+            break;
+        }
+
+        //The old frontier becomes the next board, clear what it held
+        ++distance;
+        memset(frontier + frontier_first, 0, (frontier_last - frontier_first + 1)*sizeof(u64));
+        fill->frontier = next;
+        fill->next = frontier;
+        frontier_first = next_first;
+        frontier_last = next_last;
+    }
+    return distance;
+}
+
+//Returns the neighbor of cell that is one closer to where the distances were
+//filled from.
+static i32
+bfs_step_downhill(FloodFill* fill, i32 cell) {
+    i32 grid_width = fill->grid_width;
+    i32 x = cell % grid_width;
+    i32 y = cell / grid_width;
+    i32 candidates[4] = {
+        y + 1 < fill->grid_height ? cell + grid_width : -1,
+        x > 0                     ? cell - 1 : -1,
+        x + 1 < grid_width        ? cell + 1 : -1,
+        y > 0                     ? cell - grid_width : -1,
+    };
+    i32 distance = fill->distances[cell] - 1;
+    for(i32 i = 0; i < 4; i++) {
+        i32 candidate = candidates[i];
+        if(candidate >= 0 &&
+           (fill->reached[candidate >> 6] & ((u64)1 << (candidate & 63))) &&
+           fill->distances[candidate] == distance)
+        {
+            return candidate;
+        }
+    }
+    assert(!"No cell closer to the origin");
+    return cell;
+}
+
+//Same contract as find_path_with_astar, except that when the goal can't be
+//reached the path leads to the farthest cell the start can reach, picking
+//the one closest to the goal among those.
+static i32
+find_path_with_bfs(FloodFill* fill, PathfinderWorkspace* workspace, Vec2 start, Vec2 goal,
+      Occupancy* occupancy)
+{
+    i32 grid_width = occupancy->grid_width;
+    i32 word_count = fill->word_count;
+    assert(fill->grid_width == grid_width && fill->grid_height == occupancy->grid_height);
+
+    i32 start_cell = start.y*grid_width + start.x;
+    i32 goal_cell = goal.y*grid_width + goal.x;
+
+    //The start is occupied by the head, let the search end on it
+    u64* passable = fill->passable;
+    for(i32 i = 0; i < word_count; i++) {
+        passable[i] = fill->grid_cells[i] & ~occupancy->words[i];
+    }
+    passable[start_cell >> 6] |= (u64)1 << (start_cell & 63);
+
+    Vec2* path = workspace->path;
+    i32 distance = bfs_fill_distances(fill, goal_cell, start_cell);
+    if(fill->reached[start_cell >> 6] & ((u64)1 << (start_cell & 63))) {
+        //Walk downhill from the start to the goal
+        i32 cell = start_cell;
+        path[0] = start;
+        for(i32 step = 1; step <= distance; step++) {
+            cell = bfs_step_downhill(fill, cell);
+            path[step] = { cell % grid_width, cell / grid_width };
+        }
+        assert(cell == goal_cell);
+    } else {
+        distance = bfs_fill_distances(fill, start_cell, -1);
+
+        i32 best_cell = start_cell;
+        i32 best_heuristic = 0x7fffffff;
+        for(i32 i = 0; i < word_count; i++) {
+            for(u64 word = fill->frontier[i]; word; word &= word - 1) {
+                i32 cell = i*64 + lowest_set_bit(word);
+                Vec2 pos = { cell % grid_width, cell / grid_width };
+                i32 heuristic = astar_heuristic(pos, goal);
+                if(heuristic < best_heuristic) {
+                    best_heuristic = heuristic;
+                    best_cell = cell;
+                }
+            }
+        }
+
+        //Walk downhill from there back to the start
+        i32 cell = best_cell;
+        for(i32 step = distance; step >= 0; step--) {
+            path[step] = { cell % grid_width, cell / grid_width };
+            if(step > 0) {
+                cell = bfs_step_downhill(fill, cell);
+            }
+        }
+        assert(cell == start_cell);
+    }
+
+    workspace->path_count = distance + 1;
+    return workspace->path_count;
+}
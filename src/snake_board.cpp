@@ -0,0 +1,338 @@
+static void
+init_occupancy(Occupancy* occupancy, i32 grid_width, i32 grid_height) {
+    i32 cell_count = grid_width*grid_height;
+    occupancy->grid_width = grid_width;
+    occupancy->grid_height = grid_height;
+    occupancy->word_count = (cell_count + 63) / 64;
+    occupancy->words = (u64*)calloc(occupancy->word_count, sizeof(u64));
+    occupancy->free_cells = (i32*)calloc(cell_count, sizeof(i32));
+    occupancy->free_slots = (i32*)calloc(cell_count, sizeof(i32));
+    occupancy->free_count = 0;
+    occupancy->changed_count = 0;
+    occupancy->changes_overflowed = true;
+}
+
+static void
+free_occupancy(Occupancy* occupancy) {
+    free(occupancy->words);
+    free(occupancy->free_cells);
+    free(occupancy->free_slots);
+}
+
+static void
+clear_occupancy(Occupancy* occupancy) {
+    memset(occupancy->words, 0, occupancy->word_count*sizeof(u64));
+    i32 cell_count = occupancy->grid_width*occupancy->grid_height;
+    for(i32 i = 0; i < cell_count; i++) {
+        occupancy->free_cells[i] = i;
+        occupancy->free_slots[i] = i;
+    }
+    occupancy->free_count = cell_count;
+    occupancy->changed_count = 0;
+    occupancy->changes_overflowed = true;
+}
+
+inline void
+clear_occupancy_changes(Occupancy* occupancy) {
+    occupancy->changed_count = 0;
+    occupancy->changes_overflowed = false;
+}
+
+inline void
+log_occupancy_change(Occupancy* occupancy, i32 cell) {
+    if(occupancy->changed_count < OCCUPANCY_CHANGE_CAPACITY) {
+        occupancy->changed_cells[occupancy->changed_count++] = cell;
+    } else {
+        occupancy->changes_overflowed = true;
+    }
+}
+
+inline b32
+is_occupied(Occupancy* occupancy, Vec2 pos) {
+    i32 bit = pos.y*occupancy->grid_width + pos.x;
+    return (occupancy->words[bit >> 6] >> (bit & 63)) & 1;
+}
+
+inline void
+occupy_cell(Occupancy* occupancy, Vec2 pos) {
+    i32 bit = pos.y*occupancy->grid_width + pos.x;
+    u64 mask = (u64)1 << (bit & 63);
+    if(occupancy->words[bit >> 6] & mask) {
+        return;
+    }
+    occupancy->words[bit >> 6] |= mask;
+    log_occupancy_change(occupancy, bit);
+
+    //Swap remove from the free set
+    i32 slot = occupancy->free_slots[bit];
+    i32 last_cell = occupancy->free_cells[--occupancy->free_count];
+    occupancy->free_cells[slot] = last_cell;
+    occupancy->free_slots[last_cell] = slot;
+}
+
+inline void
+release_cell(Occupancy* occupancy, Vec2 pos) {
+    i32 bit = pos.y*occupancy->grid_width + pos.x;
+    u64 mask = (u64)1 << (bit & 63);
+    if(!(occupancy->words[bit >> 6] & mask)) {
+        return;
+    }
+    occupancy->words[bit >> 6] &= ~mask;
+    log_occupancy_change(occupancy, bit);
+
+    occupancy->free_slots[bit] = occupancy->free_count;
+    occupancy->free_cells[occupancy->free_count++] = bit;
+}
+
+inline b32
+check_walkable_cell(Vec2 pos, Occupancy* occupancy) {
+    return !is_occupied(occupancy, pos);
+}
+
+//Index of the lowest set bit, word must not be 0.
+inline i32
+lowest_set_bit(u64 word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (i32)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline u64*
+alloc_flood_fill_board(FloodFill* fill) {
+    u64* board = (u64*)calloc(fill->word_count + 2*fill->padding, sizeof(u64));
+    return board + fill->padding;
+}
+
+inline void
+free_flood_fill_board(FloodFill* fill, u64* board) {
+    free(board - fill->padding);
+}
+
+static void
+init_flood_fill(FloodFill* fill, i32 grid_width, i32 grid_height) {
+    i32 cell_count = grid_width*grid_height;
+    fill->grid_width = grid_width;
+    fill->grid_height = grid_height;
+    fill->word_count = (cell_count + 63) / 64;
+    //A row shift reads up to one word past grid_width/64 words away
+    fill->padding = grid_width/64 + 2;
+    fill->not_first_column = alloc_flood_fill_board(fill);
+    fill->not_last_column = alloc_flood_fill_board(fill);
+    fill->grid_cells = alloc_flood_fill_board(fill);
+    fill->passable = alloc_flood_fill_board(fill);
+    fill->reached = alloc_flood_fill_board(fill);
+    fill->frontier = alloc_flood_fill_board(fill);
+    fill->next = alloc_flood_fill_board(fill);
+    fill->distances = (i32*)calloc(cell_count, sizeof(i32));
+    SNAKE_STAT(clear_search_counts(&fill->counts));
+    for(i32 i = 0; i < cell_count; i++) {
+        u64 mask = (u64)1 << (i & 63);
+        i32 x = i % grid_width;
+        fill->grid_cells[i >> 6] |= mask;
+        if(x > 0) {
+            fill->not_first_column[i >> 6] |= mask;
+        }
+        if(x < grid_width - 1) {
+            fill->not_last_column[i >> 6] |= mask;
+        }
+    }
+}
+
+static void
+free_flood_fill(FloodFill* fill) {
+    free_flood_fill_board(fill, fill->not_first_column);
+    free_flood_fill_board(fill, fill->not_last_column);
+    free_flood_fill_board(fill, fill->grid_cells);
+    free_flood_fill_board(fill, fill->passable);
+    free_flood_fill_board(fill, fill->reached);
+    free_flood_fill_board(fill, fill->frontier);
+    free_flood_fill_board(fill, fill->next);
+    free(fill->distances);
+}
+
+//NOTE: Writes the cells next to any cell in source into dest words first to
+//      last (without source itself unless a neighbor of it is set). source
+//      and dest must not overlap. Every search step of the flood fills and
+//      the BFS planner is one of these, so like walkable_adjacent_mask there
+//      is one version per instruction set, picked once at startup:
+//       -scalar: one word at a time
+//       -sse2:   two words at a time
+//       -avx2:   four words at a time
+//      The vector versions leave the last few words to the scalar one.
+//
+//      Moving a cell one column is a shift by one bit and one row a shift by
+//      grid_width bits, split into whole words and the bits left over.
+
+inline u64
+flood_fill_expand_word(FloodFill* fill, u64* source, i32 i, i32 row_words, i32 row_bits) {
+    u64 right = ((source[i] << 1) | (source[i - 1] >> 63)) & fill->not_first_column[i];
+    u64 left = ((source[i] >> 1) | (source[i + 1] << 63)) & fill->not_last_column[i];
+    //x >> (64 - row_bits) written so that row_bits == 0 gives 0
+    u64 above = (source[i - row_words] << row_bits) | ((source[i - row_words - 1] >> 1) >> (63 - row_bits));
+    u64 below = (source[i + row_words] >> row_bits) | ((source[i + row_words + 1] << 1) << (63 - row_bits));
+    return (left | right | above | below) & fill->grid_cells[i];
+}
+
+static void
+flood_fill_expand_words_scalar(FloodFill* fill, u64* source, u64* dest, i32 first, i32 last) {
+    i32 row_words = fill->grid_width >> 6;
+    i32 row_bits = fill->grid_width & 63;
+    for(i32 i = first; i <= last; i++) {
+        dest[i] = flood_fill_expand_word(fill, source, i, row_words, row_bits);
+    }
+}
+
+#ifdef SNAKE_X86
+//Vector shifts by 64 give 0, so unlike the scalar version the row carry can
+//shift by 64 - row_bits directly.
+SNAKE_TARGET("sse2") static void
+flood_fill_expand_words_sse2(FloodFill* fill, u64* source, u64* dest, i32 first, i32 last) {
+    i32 row_words = fill->grid_width >> 6;
+    i32 row_bits = fill->grid_width & 63;
+    __m128i row_shift = _mm_cvtsi32_si128(row_bits);
+    __m128i carry_shift = _mm_cvtsi32_si128(64 - row_bits);
+    i32 i = first;
+    for(; i + 1 <= last; i += 2) {
+        __m128i center = _mm_loadu_si128((__m128i*)(source + i));
+        __m128i right = _mm_or_si128(_mm_slli_epi64(center, 1),
+                                     _mm_srli_epi64(_mm_loadu_si128((__m128i*)(source + i - 1)), 63));
+        __m128i left = _mm_or_si128(_mm_srli_epi64(center, 1),
+                                    _mm_slli_epi64(_mm_loadu_si128((__m128i*)(source + i + 1)), 63));
+        __m128i above = _mm_or_si128(_mm_sll_epi64(_mm_loadu_si128((__m128i*)(source + i - row_words)), row_shift),
+                                     _mm_srl_epi64(_mm_loadu_si128((__m128i*)(source + i - row_words - 1)), carry_shift));
+        __m128i below = _mm_or_si128(_mm_srl_epi64(_mm_loadu_si128((__m128i*)(source + i + row_words)), row_shift),
+                                     _mm_sll_epi64(_mm_loadu_si128((__m128i*)(source + i + row_words + 1)), carry_shift));
+        right = _mm_and_si128(right, _mm_loadu_si128((__m128i*)(fill->not_first_column + i)));
+        left = _mm_and_si128(left, _mm_loadu_si128((__m128i*)(fill->not_last_column + i)));
+        __m128i spread = _mm_or_si128(_mm_or_si128(left, right), _mm_or_si128(above, below));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_and_si128(spread, _mm_loadu_si128((__m128i*)(fill->grid_cells + i))));
+    }
+    for(; i <= last; i++) {
+        dest[i] = flood_fill_expand_word(fill, source, i, row_words, row_bits);
+    }
+}
+
+SNAKE_TARGET("avx2") static void
+flood_fill_expand_words_avx2(FloodFill* fill, u64* source, u64* dest, i32 first, i32 last) {
+    i32 row_words = fill->grid_width >> 6;
+    i32 row_bits = fill->grid_width & 63;
+    __m128i row_shift = _mm_cvtsi32_si128(row_bits);
+    __m128i carry_shift = _mm_cvtsi32_si128(64 - row_bits);
+    i32 i = first;
+    for(; i + 3 <= last; i += 4) {
+        __m256i center = _mm256_loadu_si256((__m256i*)(source + i));
+        __m256i right = _mm256_or_si256(_mm256_slli_epi64(center, 1),
+                                        _mm256_srli_epi64(_mm256_loadu_si256((__m256i*)(source + i - 1)), 63));
+        __m256i left = _mm256_or_si256(_mm256_srli_epi64(center, 1),
+                                       _mm256_slli_epi64(_mm256_loadu_si256((__m256i*)(source + i + 1)), 63));
+        __m256i above = _mm256_or_si256(_mm256_sll_epi64(_mm256_loadu_si256((__m256i*)(source + i - row_words)), row_shift),
+                                        _mm256_srl_epi64(_mm256_loadu_si256((__m256i*)(source + i - row_words - 1)), carry_shift));
+        __m256i below = _mm256_or_si256(_mm256_srl_epi64(_mm256_loadu_si256((__m256i*)(source + i + row_words)), row_shift),
+                                        _mm256_sll_epi64(_mm256_loadu_si256((__m256i*)(source + i + row_words + 1)), carry_shift));
+        right = _mm256_and_si256(right, _mm256_loadu_si256((__m256i*)(fill->not_first_column + i)));
+        left = _mm256_and_si256(left, _mm256_loadu_si256((__m256i*)(fill->not_last_column + i)));
+        __m256i spread = _mm256_or_si256(_mm256_or_si256(left, right), _mm256_or_si256(above, below));
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_and_si256(spread, _mm256_loadu_si256((__m256i*)(fill->grid_cells + i))));
+    }
+    for(; i <= last; i++) {
+        dest[i] = flood_fill_expand_word(fill, source, i, row_words, row_bits);
+    }
+}
+#endif
+
+typedef void FloodFillExpandProc(FloodFill* fill, u64* source, u64* dest, i32 first, i32 last);
+
+struct FloodFillExpandVersion {
+    const char* name;
+    FloodFillExpandProc* proc;
+};
+
+static FloodFillExpandVersion
+pick_flood_fill_expand_version() {
+    FloodFillExpandVersion version = { "scalar", flood_fill_expand_words_scalar };
+#ifdef SNAKE_X86
+    if(cpu_supports_avx2()) {
+        version.name = "avx2";
+        version.proc = flood_fill_expand_words_avx2;
+    } else {
+        version.name = "sse2";
+        version.proc = flood_fill_expand_words_sse2;
+    }
+#endif
+    return version;
+}
+
+static FloodFillExpandVersion flood_fill_expand_version = pick_flood_fill_expand_version();
+
+inline void
+flood_fill_expand_words(FloodFill* fill, u64* source, u64* dest, i32 first, i32 last) {
+    flood_fill_expand_version.proc(fill, source, dest, first, last);
+}
+
+//Words that cells in words first to last can spread to in one step.
+inline void
+flood_fill_spread_words(FloodFill* fill, i32* first, i32* last) {
+    i32 reach = (fill->grid_width >> 6) + 1;
+    *first = max(*first - reach, 0);
+    *last = min(*last + reach, fill->word_count - 1);
+}
+
+//Returns true if to can be reached from from through fill->passable cells.
+//from itself doesn't have to be passable. Like bfs_fill_distances it only
+//expands the newest cells, over the words they span.
+static b32
+flood_fill_reaches(FloodFill* fill, i32 from, i32 to) {
+    if(from == to) {
+        return true;
+    }
+    i32 word_count = fill->word_count;
+    u64* passable = fill->passable;
+    u64* reached = fill->reached;
+    u64* frontier = fill->frontier;
+    u64* next = fill->next;
+
+    //Both frontier boards are kept zero outside the words the frontier spans
+    memset(reached, 0, word_count*sizeof(u64));
+    memset(frontier, 0, word_count*sizeof(u64));
+    memset(next, 0, word_count*sizeof(u64));
+    reached[from >> 6] |= (u64)1 << (from & 63);
+    frontier[from >> 6] |= (u64)1 << (from & 63);
+    i32 frontier_first = from >> 6;
+    i32 frontier_last = frontier_first;
+
+    for(;;) {
+        i32 first = frontier_first;
+        i32 last = frontier_last;
+        flood_fill_spread_words(fill, &first, &last);
+        flood_fill_expand_words(fill, frontier, next, first, last);
+
+        i32 next_first = word_count;
+        i32 next_last = -1;
+        for(i32 i = first; i <= last; i++) {
+            u64 word = next[i] & passable[i] & ~reached[i];
+            reached[i] |= word;
+            next[i] = word;
+            if(word) {
+                next_first = min(next_first, i);
+                next_last = i;
+            }
+        }
+        if(reached[to >> 6] & ((u64)1 << (to & 63))) {
+            return true;
+        }
+        if(next_last < 0) {
+            return false;
+        }
+
+        memset(frontier + frontier_first, 0, (frontier_last - frontier_first + 1)*sizeof(u64));
+        u64* swap = frontier;
+        frontier = next;
+        next = swap;
+        frontier_first = next_first;
+        frontier_last = next_last;
+    }
+}
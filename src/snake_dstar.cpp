@@ -0,0 +1,317 @@
+//NOTE: D* Lite (Koenig & Likhachev), the basic version. Searches backwards
+//      from the fruit to the head and keeps g/rhs values between ticks, so
+//      when the head moves and the tail releases a cell only the part of
+//      the search those two cells affect gets repaired. A new fruit or a
+//      reset starts over from scratch.
+//
+//      A cell is blocked while it is occupied, except for the head itself
+//      which is the start of the search.
+
+#define DSTAR_INFINITY 0x3fffffff
+
+inline b32
+dstar_key_less(DstarKey a, DstarKey b) {
+    return a.k1 < b.k1 || (a.k1 == b.k1 && a.k2 < b.k2);
+}
+
+static void
+init_dstar_lite(DstarLite* dstar, i32 grid_width, i32 grid_height) {
+    i32 cell_count = grid_width*grid_height;
+    dstar->grid_width = grid_width;
+    dstar->grid_height = grid_height;
+    dstar->cells = (DstarCell*)calloc(cell_count, sizeof(DstarCell));
+    dstar->heap = (i32*)calloc(cell_count, sizeof(i32));
+    dstar->heap_count = 0;
+    dstar->initialized = false;
+    SNAKE_STAT(clear_search_counts(&dstar->counts));
+}
+
+static void
+free_dstar_lite(DstarLite* dstar) {
+    free(dstar->cells);
+    free(dstar->heap);
+}
+
+inline i32
+dstar_cell_index(DstarLite* dstar, Vec2 pos) {
+    return pos.y*dstar->grid_width + pos.x;
+}
+
+inline Vec2
+dstar_cell_position(DstarLite* dstar, i32 index) {
+    Vec2 result = { index % dstar->grid_width, index / dstar->grid_width };
+    return result;
+}
+
+inline DstarKey
+dstar_calculate_key(DstarLite* dstar, i32 index) {
+    DstarCell* cell = &dstar->cells[index];
+    i32 m = min(cell->g, cell->rhs);
+    DstarKey key;
+    if(m >= DSTAR_INFINITY) {
+        key.k1 = DSTAR_INFINITY;
+        key.k2 = DSTAR_INFINITY;
+    } else {
+        key.k1 = m + astar_heuristic(dstar->start, dstar_cell_position(dstar, index)) + dstar->km;
+        key.k2 = m;
+    }
+    return key;
+}
+
+//Indexed binary heap of cell indices, ordered by the key stored in the cell.
+inline b32
+dstar_heap_less(DstarLite* dstar, i32 a, i32 b) {
+    return dstar_key_less(dstar->cells[a].key, dstar->cells[b].key);
+}
+
+inline void
+dstar_heap_place(DstarLite* dstar, i32 heap_index, i32 cell_index) {
+    dstar->heap[heap_index] = cell_index;
+    dstar->cells[cell_index].heap_index = heap_index;
+}
+
+static void
+dstar_heap_sift_up(DstarLite* dstar, i32 heap_index) {
+    i32 cell_index = dstar->heap[heap_index];
+    while(heap_index > 0) {
+        i32 parent = (heap_index - 1) / 2;
+        if(!dstar_heap_less(dstar, cell_index, dstar->heap[parent])) {
+            break;
+        }
+        dstar_heap_place(dstar, heap_index, dstar->heap[parent]);
+        heap_index = parent;
+    }
+    dstar_heap_place(dstar, heap_index, cell_index);
+}
+
+static void
+dstar_heap_sift_down(DstarLite* dstar, i32 heap_index) {
+    i32 cell_index = dstar->heap[heap_index];
+    for(;;) {
+        i32 child = heap_index*2 + 1;
+        if(child >= dstar->heap_count) {
+            break;
+        }
+        if(child + 1 < dstar->heap_count && dstar_heap_less(dstar, dstar->heap[child + 1], dstar->heap[child])) {
+            ++child;
+        }
+        if(!dstar_heap_less(dstar, dstar->heap[child], cell_index)) {
+            break;
+        }
+        dstar_heap_place(dstar, heap_index, dstar->heap[child]);
+        heap_index = child;
+    }
+    dstar_heap_place(dstar, heap_index, cell_index);
+}
+
+static void
+dstar_heap_insert(DstarLite* dstar, i32 cell_index, DstarKey key) {
+    SNAKE_STAT(++dstar->counts.push_count);
+    dstar->cells[cell_index].key = key;
+    i32 heap_index = dstar->heap_count++;
+    dstar_heap_place(dstar, heap_index, cell_index);
+    dstar_heap_sift_up(dstar, heap_index);
+}
+
+static void
+dstar_heap_remove(DstarLite* dstar, i32 cell_index) {
+    i32 heap_index = dstar->cells[cell_index].heap_index;
+    assert(heap_index >= 0);
+    dstar->cells[cell_index].heap_index = -1;
+    --dstar->heap_count;
+    if(heap_index == dstar->heap_count) {
+        return;
+    }
+    dstar_heap_place(dstar, heap_index, dstar->heap[dstar->heap_count]);
+    dstar_heap_sift_up(dstar, heap_index);
+    dstar_heap_sift_down(dstar, dstar->cells[dstar->heap[heap_index]].heap_index);
+}
+
+inline DstarKey
+dstar_top_key(DstarLite* dstar) {
+    if(dstar->heap_count == 0) {
+        DstarKey none = { DSTAR_INFINITY, DSTAR_INFINITY };
+        return none;
+    }
+    return dstar->cells[dstar->heap[0]].key;
+}
+
+//Fills neighbors with the in-bounds cells next to index, returns how many.
+inline i32
+dstar_neighbors(DstarLite* dstar, i32 index, i32* neighbors) {
+    Vec2 pos = dstar_cell_position(dstar, index);
+    i32 count = 0;
+    if(pos.x > 0)                      neighbors[count++] = index - 1;
+    if(pos.x + 1 < dstar->grid_width)  neighbors[count++] = index + 1;
+    if(pos.y > 0)                      neighbors[count++] = index - dstar->grid_width;
+    if(pos.y + 1 < dstar->grid_height) neighbors[count++] = index + dstar->grid_width;
+    return count;
+}
+
+//Cost of moving between two neighboring cells.
+inline i32
+dstar_cost(DstarLite* dstar, i32 from, i32 to) {
+    return (dstar->cells[from].blocked || dstar->cells[to].blocked) ? DSTAR_INFINITY : 1;
+}
+
+static void
+dstar_update_vertex(DstarLite* dstar, i32 index) {
+    DstarCell* cell = &dstar->cells[index];
+    if(index != dstar->goal_index) {
+        i32 rhs = DSTAR_INFINITY;
+        i32 neighbors[4];
+        i32 neighbor_count = dstar_neighbors(dstar, index, neighbors);
+        for(i32 i = 0; i < neighbor_count; i++) {
+            i32 cost = dstar_cost(dstar, index, neighbors[i]);
+            i32 g = dstar->cells[neighbors[i]].g;
+            if(cost < DSTAR_INFINITY && g < DSTAR_INFINITY) {
+                rhs = min(rhs, cost + g);
+            }
+        }
+        cell->rhs = rhs;
+    }
+
+    if(cell->heap_index >= 0) {
+        //Counted with the decreased keys, the cell goes back in if it is still inconsistent
+        SNAKE_STAT(++dstar->counts.decrease_key_count);
+        dstar_heap_remove(dstar, index);
+    }
+    if(cell->g != cell->rhs) {
+        dstar_heap_insert(dstar, index, dstar_calculate_key(dstar, index));
+    }
+}
+
+static void
+dstar_compute_shortest_path(DstarLite* dstar) {
+    i32 start_index = dstar_cell_index(dstar, dstar->start);
+    while(dstar->heap_count > 0 &&
+          (dstar_key_less(dstar_top_key(dstar), dstar_calculate_key(dstar, start_index)) ||
+           dstar->cells[start_index].rhs != dstar->cells[start_index].g))
+    {
+        i32 index = dstar->heap[0];
+        DstarKey old_key = dstar->cells[index].key;
+        DstarKey new_key = dstar_calculate_key(dstar, index);
+        SNAKE_STAT(++dstar->counts.pop_count);
+        dstar_heap_remove(dstar, index);
+
+        DstarCell* cell = &dstar->cells[index];
+        i32 neighbors[4];
+        i32 neighbor_count = dstar_neighbors(dstar, index, neighbors);
+        if(dstar_key_less(old_key, new_key)) {
+            dstar_heap_insert(dstar, index, new_key);
+        } else if(cell->g > cell->rhs) {
+            cell->g = cell->rhs;
+            for(i32 i = 0; i < neighbor_count; i++) {
+                dstar_update_vertex(dstar, neighbors[i]);
+            }
+        } else {
+            cell->g = DSTAR_INFINITY;
+            dstar_update_vertex(dstar, index);
+            for(i32 i = 0; i < neighbor_count; i++) {
+                dstar_update_vertex(dstar, neighbors[i]);
+            }
+        }
+    }
+}
+
+static void
+dstar_set_blocked(DstarLite* dstar, i32 index, b32 blocked) {
+    if(dstar->cells[index].blocked == blocked) {
+        return;
+    }
+    dstar->cells[index].blocked = blocked;
+
+    dstar_update_vertex(dstar, index);
+    i32 neighbors[4];
+    i32 neighbor_count = dstar_neighbors(dstar, index, neighbors);
+    for(i32 i = 0; i < neighbor_count; i++) {
+        dstar_update_vertex(dstar, neighbors[i]);
+    }
+}
+
+static void
+dstar_initialize(DstarLite* dstar, Vec2 start, Vec2 goal, Occupancy* occupancy) {
+    i32 cell_count = dstar->grid_width*dstar->grid_height;
+    for(i32 i = 0; i < cell_count; i++) {
+        DstarCell* cell = &dstar->cells[i];
+        cell->g = DSTAR_INFINITY;
+        cell->rhs = DSTAR_INFINITY;
+        cell->heap_index = -1;
+        cell->blocked = is_occupied(occupancy, dstar_cell_position(dstar, i));
+    }
+    dstar->heap_count = 0;
+    dstar->km = 0;
+    dstar->start = start;
+    dstar->goal = goal;
+    dstar->goal_index = dstar_cell_index(dstar, goal);
+    dstar->cells[dstar_cell_index(dstar, start)].blocked = false;
+    dstar->cells[dstar->goal_index].rhs = 0;
+    dstar_heap_insert(dstar, dstar->goal_index, dstar_calculate_key(dstar, dstar->goal_index));
+    dstar->initialized = true;
+}
+
+//Same contract as find_path_with_astar, except that it uses and updates the
+//search state kept in dstar and consumes the occupancy change log.
+static i32
+find_path_with_dstar_lite(DstarLite* dstar, PathfinderWorkspace* workspace,
+                          Vec2 start, Vec2 goal, Occupancy* occupancy)
+{
+    assert(dstar->grid_width == occupancy->grid_width && dstar->grid_height == occupancy->grid_height);
+
+    if(!dstar->initialized || goal != dstar->goal || occupancy->changes_overflowed) {
+        dstar_initialize(dstar, start, goal, occupancy);
+    } else {
+        //Repair what changed since the last call: the previous start is now
+        //an ordinary (body) cell, plus every cell in the change log.
+        Vec2 last_start = dstar->start;
+        dstar->km += astar_heuristic(last_start, start);
+        dstar->start = start;
+
+        i32 start_index = dstar_cell_index(dstar, start);
+        dstar_set_blocked(dstar, start_index, false);
+        dstar_set_blocked(dstar, dstar_cell_index(dstar, last_start), is_occupied(occupancy, last_start) && last_start != start);
+        for(i32 i = 0; i < occupancy->changed_count; i++) {
+            i32 index = occupancy->changed_cells[i];
+            if(index != start_index) {
+                dstar_set_blocked(dstar, index, is_occupied(occupancy, dstar_cell_position(dstar, index)));
+            }
+        }
+    }
+    clear_occupancy_changes(occupancy);
+
+    dstar_compute_shortest_path(dstar);
+
+    i32 index = dstar_cell_index(dstar, start);
+    if(dstar->cells[index].g >= DSTAR_INFINITY) {
+        //No way to the goal, fall back to A* and the cell it ends up on
+        i32 path_count = find_path_with_astar(workspace, start, goal, occupancy, false);
+        SNAKE_STAT(take_search_counts(&dstar->counts, &workspace->open_set.counts));
+        return path_count;
+    }
+
+    //Walk downhill on g from the start to the goal
+    i32 count = 0;
+    workspace->path[count++] = start;
+    while(index != dstar->goal_index && count < workspace->max_count) {
+        i32 neighbors[4];
+        i32 neighbor_count = dstar_neighbors(dstar, index, neighbors);
+        i32 best_index = -1;
+        i32 best_cost = DSTAR_INFINITY;
+        for(i32 i = 0; i < neighbor_count; i++) {
+            i32 cost = dstar_cost(dstar, index, neighbors[i]);
+            i32 g = dstar->cells[neighbors[i]].g;
+            if(cost < DSTAR_INFINITY && g < DSTAR_INFINITY && cost + g < best_cost) {
+                best_cost = cost + g;
+                best_index = neighbors[i];
+            }
+        }
+        if(best_index < 0) {
+            break;
+        }
+        index = best_index;
+        workspace->path[count++] = dstar_cell_position(dstar, index);
+    }
+
+    workspace->path_count = count;
+    return count;
+}
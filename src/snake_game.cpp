@@ -0,0 +1,602 @@
+static const char* planner_names[PLANNER_COUNT] = {
+    "astar",
+    "jps",
+    "dstar",
+    "timed",
+    "hamilton",
+    "bfs",
+};
+
+//Segment 0 is the head and segment snake_cell_count-1 the tail.
+inline Vec2*
+snake_segment(Game* game, i32 segment) {
+    i32 index = game->head_index - segment;
+    if(index < 0) {
+        index += game->max_cell_count;
+    }
+    return &game->positions[index];
+}
+
+//Returns false if there is no free cell left to put the fruit on.
+static b32
+randomize_fruit_pos(Game* game) {
+    Occupancy* occupancy = &game->occupancy;
+    if(occupancy->free_count == 0) {
+        return false;
+    }
+    i32 cell = occupancy->free_cells[random_below(&game->rng, occupancy->free_count)];
+    game->fruit_pos.x = cell % game->grid_width;
+    game->fruit_pos.y = cell / game->grid_width;
+    return true;
+}
+
+static void
+default_game_config(GameConfig* config) {
+    config->grid_width = 8;
+    config->grid_height = 8;
+    config->start_frame_time = 0.2;
+    config->min_frame_time = 0.00015;
+    config->speed_up_rate = 0.95;
+    config->planner = PLANNER_ASTAR;
+    config->tail_safety = true;
+}
+
+//Tries to consume the argument at argv[*index] (and its value) as a game
+//setting. Returns false if it isn't one, leaving *index alone.
+static b32
+parse_game_arg(i32 argc, char** argv, i32* index, GameConfig* config) {
+    const char* arg = argv[*index];
+    const char* value = (*index + 1 < argc) ? argv[*index + 1] : 0;
+    if(!value) {
+        return false;
+    }
+
+    if(strcmp(arg, "--grid") == 0) {
+        config->grid_width = atoi(value);
+        config->grid_height = config->grid_width;
+    } else if(strcmp(arg, "--grid-width") == 0) {
+        config->grid_width = atoi(value);
+    } else if(strcmp(arg, "--grid-height") == 0) {
+        config->grid_height = atoi(value);
+    } else if(strcmp(arg, "--tick") == 0) {
+        config->start_frame_time = atof(value);
+    } else if(strcmp(arg, "--min-tick") == 0) {
+        config->min_frame_time = atof(value);
+    } else if(strcmp(arg, "--speed-up") == 0) {
+        config->speed_up_rate = atof(value);
+    } else if(strcmp(arg, "--tail-safety") == 0) {
+        config->tail_safety = atoi(value) != 0;
+    } else if(strcmp(arg, "--planner") == 0) {
+        config->planner = -1;
+        for(i32 i = 0; i < PLANNER_COUNT; i++) {
+            if(strcmp(value, planner_names[i]) == 0) {
+                config->planner = i;
+            }
+        }
+    } else {
+        return false;
+    }
+    ++*index;
+    return true;
+}
+
+static b32
+validate_game_config(GameConfig* config) {
+    //The snake starts out three segments long, so at least a 2x2 board
+    if(config->grid_width < 2 || config->grid_height < 2) {
+        fprintf(stderr, "Grid has to be at least 2x2\n");
+        return false;
+    }
+    if((i64)config->grid_width*(i64)config->grid_height > (1 << 28)) {
+        fprintf(stderr, "Grid %dx%d is too large\n", config->grid_width, config->grid_height);
+        return false;
+    }
+    if(config->start_frame_time <= 0 || config->min_frame_time <= 0 || config->speed_up_rate <= 0) {
+        fprintf(stderr, "Tick timings have to be positive\n");
+        return false;
+    }
+    if(config->planner < 0 || config->planner >= PLANNER_COUNT) {
+        fprintf(stderr, "Unknown planner, pick one of:");
+        for(i32 i = 0; i < PLANNER_COUNT; i++) {
+            fprintf(stderr, " %s", planner_names[i]);
+        }
+        fprintf(stderr, "\n");
+        return false;
+    }
+    if(config->planner == PLANNER_HAMILTON && (config->grid_width*config->grid_height) % 2 != 0) {
+        fprintf(stderr, "The hamilton planner needs an even grid width or height\n");
+        return false;
+    }
+    return true;
+}
+
+//Everything random in a game comes from this seed.
+static void
+seed_game(Game* game, u64 seed) {
+    game->seed = seed;
+    seed_random(&game->rng, seed);
+}
+
+static void
+init_game(Game* game, GameConfig* config) {
+    game->start_frame_time = config->start_frame_time;
+    game->min_frame_time = config->min_frame_time;
+    game->speed_up_rate = config->speed_up_rate;
+    game->grid_width = config->grid_width;
+    game->grid_height = config->grid_height;
+    game->frame_time = 0;
+    game->snake_cell_count = 0;
+    game->max_cell_count = game->grid_width * game->grid_height;
+    game->input = 0;
+    game->positions = (Vec2*)calloc(game->max_cell_count, sizeof(Vec2));
+    game->head_index = 0;
+    init_occupancy(&game->occupancy, game->grid_width, game->grid_height);
+    game->planner = config->planner;
+    init_pathfinder_workspace(&game->pathfinder, game->max_cell_count);
+    if(game->planner == PLANNER_DSTAR_LITE) {
+        init_dstar_lite(&game->dstar, game->grid_width, game->grid_height);
+    }
+    game->path_step = 0;
+    game->shortcut_fruit_pos.x = -1;
+    game->shortcut_fruit_pos.y = -1;
+    game->path_cache_hits = 0;
+    game->path_cache_misses = 0;
+    game->tail_safety = config->tail_safety;
+    init_flood_fill(&game->flood_fill, game->grid_width, game->grid_height);
+    game->tail_chases = 0;
+    SNAKE_STAT(clear_hot_path_stats(&game->stats));
+    game->replay = 0;
+    game->tail_chase_ticks = 0;
+    if(game->planner == PLANNER_HAMILTON) {
+        b32 has_cycle = init_hamilton_cycle(&game->cycle, game->grid_width, game->grid_height);
+        assert(has_cycle);
+    }
+    game->direction = RIGHT;
+    game->collided = false;
+    game->game_over_cause = GAME_OVER_NONE;
+    game->flash_count   = 5;
+    game->flash_counter = 0;
+    game->fruit_pos = { 0 };
+    game->score = 0;
+    game->ticks_since_fruit = 0;
+    seed_game(game, 0);
+}
+
+static void
+free_game(Game* game) {
+    free(game->positions);
+    free_occupancy(&game->occupancy);
+    free_pathfinder_workspace(&game->pathfinder);
+    free_flood_fill(&game->flood_fill);
+    if(game->planner == PLANNER_DSTAR_LITE) {
+        free_dstar_lite(&game->dstar);
+    }
+    if(game->planner == PLANNER_HAMILTON) {
+        free_hamilton_cycle(&game->cycle);
+    }
+}
+
+static void
+reset_state(Game* game) {
+    game->collided = false;
+    game->game_over_cause = GAME_OVER_NONE;
+
+    Vec2 snake_pos;
+    snake_pos.x = random_below(&game->rng, game->grid_width);
+    snake_pos.y = random_below(&game->rng, game->grid_height);
+
+    clear_occupancy(&game->occupancy);
+    occupy_cell(&game->occupancy, snake_pos);
+
+    randomize_fruit_pos(game);
+    if(game->replay) {
+        record_replay_start(game->replay, snake_pos, game->fruit_pos);
+    }
+
+    game->head_index = 0;
+    for(i32 i = 0; i < game->max_cell_count; i++) {
+        game->positions[i] = snake_pos;
+    }
+
+    game->input = -1;
+    game->snake_cell_count = 3;
+    game->flash_counter = 0;
+    game->score = 0;
+    game->ticks_since_fruit = 0;
+    game->path_step = 0;
+    game->shortcut_fruit_pos.x = -1;
+    game->shortcut_fruit_pos.y = -1;
+    game->path_cache_hits = 0;
+    game->path_cache_misses = 0;
+    game->tail_chases = 0;
+    game->tail_chase_ticks = 0;
+    game->frame_time = game->start_frame_time;
+}
+
+//Fills in pathfinder.release_steps from the body. The segment i ticks
+//behind the head leaves its cell snake_cell_count - i ticks from now, as long
+//as the snake doesn't grow on the way. Where segments are stacked the one
+//closest to the head decides.
+static void
+fill_release_steps(Game* game) {
+    i32* release_steps = game->pathfinder.release_steps;
+    for(i32 i = game->snake_cell_count - 1; i >= 0; i--) {
+        Vec2 pos = *snake_segment(game, i);
+        release_steps[pos.y*game->grid_width + pos.x] = game->snake_cell_count - i;
+    }
+}
+
+//Plans from start to goal with the game's planner, the path ends up in
+//game->pathfinder.path. Returns its length.
+static i32
+plan_path(Game* game, Vec2 start, Vec2 goal) {
+    i64 trace_start_ns = trace_begin();
+    i32 path_count;
+    switch(game->planner) {
+        case PLANNER_JPS:
+            path_count = find_path_with_jps(&game->pathfinder, start, goal, &game->occupancy);
+        break;
+        case PLANNER_DSTAR_LITE:
+            path_count = find_path_with_dstar_lite(&game->dstar, &game->pathfinder, start, goal, &game->occupancy);
+        break;
+        case PLANNER_BFS:
+            path_count = find_path_with_bfs(&game->flood_fill, &game->pathfinder, start, goal, &game->occupancy);
+        break;
+        case PLANNER_TIMED_ASTAR:
+            fill_release_steps(game);
+            path_count = find_path_with_astar(&game->pathfinder, start, goal, &game->occupancy, true);
+        break;
+        default:
+            path_count = find_path_with_astar(&game->pathfinder, start, goal, &game->occupancy, false);
+        break;
+    }
+#if SNAKE_STATS
+    SearchCounts* counts = &game->pathfinder.open_set.counts;
+    if(game->planner == PLANNER_DSTAR_LITE) {
+        counts = &game->dstar.counts;
+    } else if(game->planner == PLANNER_BFS) {
+        counts = &game->flood_fill.counts;
+    }
+    record_plan_stats(&game->stats, counts, path_count);
+#endif
+    trace_end("pathfinding", trace_start_ns);
+    return path_count;
+}
+
+//Returns false if eating the fruit at the end of the planned path would leave
+//the head without a way back to the tail. The body is laid out the way it
+//will be right after eating, the path back from the fruit followed by what
+//is left of the current body, and flood filled from the head.
+static b32
+path_keeps_tail_reachable(Game* game) {
+    PathfinderWorkspace* pathfinder = &game->pathfinder;
+    FloodFill* fill = &game->flood_fill;
+    i32 length = game->snake_cell_count + 1;
+    if(length >= game->max_cell_count) {
+        //Eating this one fills the board
+        return true;
+    }
+
+    memcpy(fill->passable, fill->grid_cells, fill->word_count*sizeof(u64));
+    i32 moves = pathfinder->path_count - 1;
+    i32 tail_cell = 0;
+    for(i32 i = 0; i < length; i++) {
+        Vec2 pos = (i < moves) ? pathfinder->path[moves - i] : *snake_segment(game, i - moves);
+        tail_cell = pos.y*game->grid_width + pos.x;
+        fill->passable[tail_cell >> 6] &= ~((u64)1 << (tail_cell & 63));
+    }
+    //The head may follow the tail onto its cell
+    fill->passable[tail_cell >> 6] |= (u64)1 << (tail_cell & 63);
+
+    Vec2 head = pathfinder->path[moves];
+    return flood_fill_reaches(fill, head.y*game->grid_width + head.x, tail_cell);
+}
+
+//Plans a path from the head to the tail into game->pathfinder, the time-aware
+//search lets it end on the tail's cell. Returns false if there is none.
+static b32
+plan_path_to_tail(Game* game) {
+    Vec2 head = *snake_segment(game, 0);
+    Vec2 tail = *snake_segment(game, game->snake_cell_count - 1);
+    i64 trace_start_ns = trace_begin();
+    fill_release_steps(game);
+    i32 path_count = find_path_with_astar(&game->pathfinder, head, tail, &game->occupancy, true);
+    //Only plans to the fruit are counted
+    SNAKE_STAT(clear_search_counts(&game->pathfinder.open_set.counts));
+    trace_end("pathfinding", trace_start_ns);
+    return path_count > 1 && game->pathfinder.path[path_count - 1] == tail;
+}
+
+//True if the head can move onto pos on the next tick. Besides free cells
+//that is the tail, which moves out of the way on the same tick. The fruit is
+//never on the tail so the snake can't be growing then.
+inline b32
+free_next_tick(Game* game, Vec2 pos) {
+    if(!is_occupied(&game->occupancy, pos)) {
+        return true;
+    }
+    i32 tail = game->snake_cell_count - 1;
+    return pos == *snake_segment(game, tail) && pos != *snake_segment(game, tail - 1);
+}
+
+//Returns the step to take next along the last planned path, or 0 if that
+//path doesn't lead from head to the fruit anymore or its next cell is taken.
+static i32
+cached_path_step(Game* game, Vec2 head) {
+    PathfinderWorkspace* pathfinder = &game->pathfinder;
+    i32 step = game->path_step;
+    if(step > 0 && step < pathfinder->path_count &&
+       pathfinder->path[step - 1] == head &&
+       pathfinder->path[pathfinder->path_count - 1] == game->fruit_pos &&
+       free_next_tick(game, pathfinder->path[step]))
+    {
+        return step;
+    }
+    return 0;
+}
+
+//Finds the cell to move to from head. Keeps following the last planned path
+//while it still leads to the fruit and its next cell is free, which is most
+//ticks, and only runs the planner when that isn't the case. D* Lite repairs
+//its own search every tick so it always plans. Returns false if there is
+//nowhere to go.
+static b32
+next_path_cell(Game* game, Vec2 head, Vec2* next) {
+    PathfinderWorkspace* pathfinder = &game->pathfinder;
+    Vec2* path = pathfinder->path;
+    i32 step = (game->planner != PLANNER_DSTAR_LITE) ? cached_path_step(game, head) : 0;
+    if(step > 0) {
+        ++game->path_cache_hits;
+    } else {
+        ++game->path_cache_misses;
+        step = 1; //First element is our own position
+        if(plan_path(game, head, game->fruit_pos) <= step) {
+            game->path_step = 0;
+            return false;
+        }
+        //Chase the tail until the fruit can be eaten safely. A full lap behind
+        //the tail brings the body back to where it started, if the fruit is
+        //still unsafe by then it stays that way and the snake goes for it.
+        if(game->tail_safety && path[pathfinder->path_count - 1] == game->fruit_pos) {
+            if(game->tail_chase_ticks < game->snake_cell_count && !path_keeps_tail_reachable(game)) {
+                ++game->tail_chases;
+                ++game->tail_chase_ticks;
+                Vec2 unsafe_next = path[step];
+                if(!plan_path_to_tail(game)) {
+                    *next = unsafe_next;
+                    game->path_step = 0;
+                    return true;
+                }
+            } else {
+                game->tail_chase_ticks = 0;
+            }
+        }
+    }
+
+    *next = path[step];
+    //A path that stops short of the fruit gets planned again next tick, the
+    //way there may have opened up by then
+    game->path_step = (path[pathfinder->path_count - 1] == game->fruit_pos) ? step + 1 : 0;
+    return true;
+}
+
+//Cells the head keeps free between itself and the tail when it cuts across
+//the cycle, the tail stays put on the tick the snake grows.
+#define HAMILTON_TAIL_MARGIN 3
+
+//Follows the Hamiltonian cycle. While the snake is shorter than half the
+//board it may cut ahead along the planned path to the fruit, as long as that
+//doesn't skip past the fruit and stays behind the tail in cycle order. The
+//body then always lies between the tail and the head along the cycle, so
+//every cell ahead of the head up to the tail is free.
+//
+//Most ticks just follow the cycle, so the planner only runs for a new fruit
+//or to continue after a shortcut. The path stays cached while the head keeps
+//to it, a tick that leaves it for the cycle drops it.
+static b32
+next_hamilton_cell(Game* game, Vec2 head, Vec2* next) {
+    HamiltonCycle* cycle = &game->cycle;
+    i32 grid_width = game->grid_width;
+    i32 head_cell = head.y*grid_width + head.x;
+    i32 next_cell = hamilton_next_cell(cycle, head_cell);
+
+    if(game->snake_cell_count*2 < game->max_cell_count) {
+        PathfinderWorkspace* pathfinder = &game->pathfinder;
+        i32 step = cached_path_step(game, head);
+        if(step > 0) {
+            ++game->path_cache_hits;
+        } else if(game->shortcut_fruit_pos != game->fruit_pos) {
+            ++game->path_cache_misses;
+            game->shortcut_fruit_pos = game->fruit_pos;
+            i32 path_count = plan_path(game, head, game->fruit_pos);
+            if(path_count > 1 && pathfinder->path[path_count - 1] == game->fruit_pos) {
+                step = 1; //First element is our own position
+            }
+        }
+
+        game->path_step = 0;
+        if(step > 0) {
+            Vec2 shortcut = pathfinder->path[step];
+            Vec2 tail = *snake_segment(game, game->snake_cell_count - 1);
+            i32 shortcut_cell = shortcut.y*grid_width + shortcut.x;
+            i32 skip = hamilton_distance(cycle, head_cell, shortcut_cell);
+            i32 tail_distance = hamilton_distance(cycle, head_cell, tail.y*grid_width + tail.x);
+            if(tail_distance == 0) {
+                //All segments are still stacked on the start cell
+                tail_distance = cycle->length;
+            }
+            i32 fruit_distance = hamilton_distance(cycle, head_cell, game->fruit_pos.y*grid_width + game->fruit_pos.x);
+            if(skip > 1 && skip <= fruit_distance && skip < tail_distance - HAMILTON_TAIL_MARGIN) {
+                next_cell = shortcut_cell;
+                //Plan again if the path turns out to be blocked further on
+                game->shortcut_fruit_pos.x = -1;
+                game->shortcut_fruit_pos.y = -1;
+            }
+            if(next_cell == shortcut_cell) {
+                game->path_step = step + 1;
+            }
+        }
+    }
+
+    next->x = next_cell % grid_width;
+    next->y = next_cell / grid_width;
+    return true;
+}
+
+//Steps of a move in direction. Branch free, like is_off_grid, so the
+//lockstep runner can work out the moves of many games in one vector loop.
+inline i32
+direction_dx(i32 direction) {
+    return (direction == RIGHT) - (direction == LEFT);
+}
+
+inline i32
+direction_dy(i32 direction) {
+    return (direction == UP) - (direction == DOWN);
+}
+
+inline b32
+is_off_grid(i32 x, i32 y, i32 grid_width, i32 grid_height) {
+    return ((u32)x >= (u32)grid_width) | ((u32)y >= (u32)grid_height);
+}
+
+//Moves the head onto snake_pos, one cell from it in game->direction, and
+//settles what that runs into. off_grid and grows say whether snake_pos is
+//off the grid or on the fruit, see move_snake.
+static void
+settle_snake_move(Game* game, Vec2 snake_pos, b32 off_grid, b32 grows) {
+    if(game->replay) {
+        record_replay_move(game->replay, game->direction);
+    }
+
+    if(off_grid) {
+        //Edge collision, the head stays where it was
+        game->collided = true;
+        game->game_over_cause = GAME_OVER_WALL;
+        if(game->replay) {
+            record_replay_end(game->replay, GAME_OVER_WALL);
+        }
+        return;
+    }
+
+    //The tail moves out of the way before the head moves in, unless the snake
+    //grows this tick. The cell is only released if no segment is left on it,
+    //the snake starts out with all of its segments stacked on one cell.
+    Vec2 old_tail = *snake_segment(game, game->snake_cell_count-1);
+    if(!grows && *snake_segment(game, game->snake_cell_count-2) != old_tail) {
+        release_cell(&game->occupancy, old_tail);
+    }
+
+    if(is_occupied(&game->occupancy, snake_pos)) {
+        game->collided = true;
+        game->game_over_cause = GAME_OVER_SELF;
+    }
+    occupy_cell(&game->occupancy, snake_pos);
+
+    if(grows) {
+        game->frame_time = max(game->min_frame_time, game->frame_time * game->speed_up_rate);
+        i32 increment = game->snake_cell_count + 1;
+        game->snake_cell_count = min(increment, game->max_cell_count);
+        ++game->score;
+        game->ticks_since_fruit = 0;
+        if(!randomize_fruit_pos(game)) {
+            //The snake fills the whole board, start over
+            game->collided = true;
+            game->game_over_cause = GAME_OVER_BOARD_FULL;
+        } else if(game->replay) {
+            record_replay_fruit(game->replay, game->fruit_pos);
+        }
+    }
+    if(game->replay && game->collided) {
+        record_replay_end(game->replay, game->game_over_cause);
+    }
+
+    //Pushing the new head overwrites the old tail slot unless the snake grew
+    game->head_index = (game->head_index + 1) % game->max_cell_count;
+    game->positions[game->head_index] = snake_pos;
+}
+
+//Moves the snake one cell in its direction and settles what that runs into.
+static void
+move_snake(Game* game) {
+    Vec2 snake_pos = *snake_segment(game, 0);
+    snake_pos.x += direction_dx(game->direction);
+    snake_pos.y += direction_dy(game->direction);
+    settle_snake_move(game, snake_pos,
+                      is_off_grid(snake_pos.x, snake_pos.y, game->grid_width, game->grid_height),
+                      snake_pos == game->fruit_pos);
+}
+
+//Counts the tick and points game->direction at the cell to move to next.
+static void
+steer_snake(Game* game) {
+    Vec2 snake_pos = *snake_segment(game, 0);
+    ++game->ticks_since_fruit;
+
+#if 0
+    //Player input
+    switch(game->input) {
+        case UP:
+            if(game->direction == RIGHT || game->direction == LEFT) {
+                game->direction = UP;
+            }
+        break;
+        case DOWN:
+            if(game->direction == RIGHT || game->direction == LEFT) {
+                game->direction = DOWN;
+            }
+        break;
+        case RIGHT:
+            if(game->direction == UP || game->direction == DOWN) {
+                game->direction = RIGHT;
+            }
+        break;
+        case LEFT:
+            if(game->direction == UP || game->direction == DOWN) {
+                game->direction = LEFT;
+            }
+        break;
+    }
+#else
+    //Astar
+    Vec2 path_next_pos;
+    b32 has_next = (game->planner == PLANNER_HAMILTON) ?
+        next_hamilton_cell(game, snake_pos, &path_next_pos) :
+        next_path_cell(game, snake_pos, &path_next_pos);
+    if(has_next) {
+        if(path_next_pos.x == snake_pos.x) { //UP/DOWN
+            if(path_next_pos.y > snake_pos.y) {
+                game->direction = UP;
+            } else if(path_next_pos.y < snake_pos.y) {
+                game->direction = DOWN;
+            } else {
+                //Should never happen
+            }
+        } else if(path_next_pos.y == snake_pos.y) { //LEFT/RIGHT
+            if(path_next_pos.x > snake_pos.x) {
+                game->direction = RIGHT;
+            } else if(path_next_pos.x < snake_pos.x) {
+                game->direction = LEFT;
+            } else {
+                //Should never happen
+            }
+        } else {
+            //Should never happen
+        }
+    }
+#endif
+}
+
+static void
+game_loop(Game* game) {
+    i64 trace_start_ns = trace_begin();
+    SNAKE_STAT(i64 plan_start_ns = stats_get_ns());
+    steer_snake(game);
+
+    SNAKE_STAT(i64 move_start_ns = stats_get_ns());
+    move_snake(game);
+    SNAKE_STAT(game->stats.plan_ns += move_start_ns - plan_start_ns);
+    SNAKE_STAT(game->stats.move_ns += stats_get_ns() - move_start_ns);
+    SNAKE_STAT(++game->stats.ticks);
+    trace_end("game_loop", trace_start_ns);
+}
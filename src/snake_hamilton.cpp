@@ -0,0 +1,69 @@
+//NOTE: A Hamiltonian cycle visits every cell of the grid once and comes back
+//      to where it started. A snake that only ever moves along it can't run
+//      into itself and fills the whole board. One exists as long as the grid
+//      has an even number of cells.
+//
+//      For an even height the cycle runs along the bottom row, zig-zags up
+//      through columns 1 and up and comes back down column 0:
+//
+//          <<<<<
+//          v>>>^
+//          v^<<<
+//          >>>>^
+//
+//      An odd height with an even width uses the same layout transposed.
+
+//Returns false if the grid has no Hamiltonian cycle.
+static b32
+init_hamilton_cycle(HamiltonCycle* cycle, i32 grid_width, i32 grid_height) {
+    i32 cell_count = grid_width*grid_height;
+    cycle->length = cell_count;
+    cycle->order = (i32*)calloc(cell_count, sizeof(i32));
+    cycle->cells = (i32*)calloc(cell_count, sizeof(i32));
+    if(cell_count % 2 != 0) {
+        return false;
+    }
+
+    //Walk the layout in (u, v) with v the even side, then map to (x, y)
+    b32 transposed = grid_height % 2 != 0;
+    i32 u_size = transposed ? grid_height : grid_width;
+    i32 v_size = transposed ? grid_width : grid_height;
+    i32 position = 0;
+    for(i32 u = 0; u < u_size; u++) {
+        cycle->cells[position++] = transposed ? u*grid_width : u;
+    }
+    for(i32 v = 1; v < v_size; v++) {
+        for(i32 i = 1; i < u_size; i++) {
+            i32 u = (v % 2 == 1) ? u_size - i : i;
+            cycle->cells[position++] = transposed ? u*grid_width + v : v*grid_width + u;
+        }
+    }
+    for(i32 v = v_size - 1; v > 0; v--) {
+        cycle->cells[position++] = transposed ? v : v*grid_width;
+    }
+    assert(position == cell_count);
+
+    for(i32 i = 0; i < cell_count; i++) {
+        cycle->order[cycle->cells[i]] = i;
+    }
+    return true;
+}
+
+static void
+free_hamilton_cycle(HamiltonCycle* cycle) {
+    free(cycle->order);
+    free(cycle->cells);
+}
+
+//Number of steps along the cycle from one cell to the other.
+inline i32
+hamilton_distance(HamiltonCycle* cycle, i32 from_cell, i32 to_cell) {
+    i32 distance = cycle->order[to_cell] - cycle->order[from_cell];
+    return distance < 0 ? distance + cycle->length : distance;
+}
+
+inline i32
+hamilton_next_cell(HamiltonCycle* cycle, i32 cell) {
+    i32 position = cycle->order[cell] + 1;
+    return cycle->cells[position == cycle->length ? 0 : position];
+}
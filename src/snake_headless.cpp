@@ -0,0 +1,843 @@
+//NOTE: Runs the simulation without any window or renderer, as fast as it goes.
+//      Nothing in here may touch SDL so it can be built without linking it.
+
+struct HeadlessConfig {
+    GameConfig game;
+    i64 game_count;
+    //A game is ended when the snake goes this many ticks without eating,
+    //otherwise a snake that can't reach the fruit could circle forever.
+    i32 starvation_ticks;
+    i32 thread_count;
+    i32 lane_count; //Games per thread run in lockstep, 1 plays them one by one
+    u64 seed; //Game n is seeded with mix_seed(seed, n)
+    const char* trace_path; //Chrome trace of the run if set
+    const char* record_path; //Replay of every game if set
+    const char* replay_path; //Only prints this replay if set
+    const char* verify_path; //Only plays this replay again and compares it if set
+};
+
+struct HeadlessStats {
+    i64 games;
+    i64 ticks;
+    i64 total_score;
+    i64 path_cache_hits;
+    i64 path_cache_misses;
+    i64 tail_chases;
+#if SNAKE_STATS
+    HotPathStats hot_path;
+#endif
+    i32 min_score;
+    i32 max_score;
+    i64 deaths[GAME_OVER_CAUSE_COUNT];
+    i64* score_histogram; //Games per final score, histogram_size entries
+    i32 histogram_size;
+    f64 seconds;
+};
+
+static const char* game_over_cause_names[GAME_OVER_CAUSE_COUNT] = {
+    "none",
+    "wall",
+    "self",
+    "board full",
+    "starved",
+};
+
+static f64
+headless_get_time() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<f64>(now).count();
+}
+
+static void
+default_headless_config(HeadlessConfig* config) {
+    default_game_config(&config->game);
+    config->game_count = 1000;
+    config->starvation_ticks = 0; //0 picks a limit based on the grid size
+    config->thread_count = 1;
+    config->lane_count = 1;
+    config->trace_path = 0;
+    config->record_path = 0;
+    config->replay_path = 0;
+    config->verify_path = 0;
+    config->seed = default_random_seed();
+}
+
+static void
+init_headless_stats(HeadlessStats* stats, i32 cell_count) {
+    memset(stats, 0, sizeof(*stats));
+    stats->min_score = 0x7fffffff;
+    //A snake can't eat more fruits than there are cells
+    stats->histogram_size = cell_count + 1;
+    stats->score_histogram = (i64*)calloc(stats->histogram_size, sizeof(i64));
+}
+
+static void
+free_headless_stats(HeadlessStats* stats) {
+    free(stats->score_histogram);
+    stats->score_histogram = 0;
+}
+
+static void
+merge_headless_stats(HeadlessStats* dest, HeadlessStats* source) {
+    assert(dest->histogram_size == source->histogram_size);
+    dest->games += source->games;
+    dest->ticks += source->ticks;
+    dest->total_score += source->total_score;
+    dest->path_cache_hits += source->path_cache_hits;
+    dest->path_cache_misses += source->path_cache_misses;
+    dest->tail_chases += source->tail_chases;
+    SNAKE_STAT(merge_hot_path_stats(&dest->hot_path, &source->hot_path));
+    dest->min_score = min(dest->min_score, source->min_score);
+    dest->max_score = max(dest->max_score, source->max_score);
+    for(i32 i = 0; i < GAME_OVER_CAUSE_COUNT; i++) {
+        dest->deaths[i] += source->deaths[i];
+    }
+    for(i32 i = 0; i < dest->histogram_size; i++) {
+        dest->score_histogram[i] += source->score_histogram[i];
+    }
+}
+
+static i32
+headless_starvation_ticks(HeadlessConfig* config) {
+    if(config->starvation_ticks > 0) {
+        return config->starvation_ticks;
+    }
+    return config->game.grid_width*config->game.grid_height*4;
+}
+
+//Returns true if the game ended with the last tick. A game that went
+//starvation_ticks without eating ends starved.
+static b32
+headless_game_over(Game* game, i32 starvation_ticks) {
+    if(game->ticks_since_fruit >= starvation_ticks) {
+        game->game_over_cause = GAME_OVER_STARVED;
+        if(game->replay) {
+            record_replay_end(game->replay, GAME_OVER_STARVED);
+        }
+        return true;
+    }
+    return game->collided;
+}
+
+//Adds a game that ended to stats.
+static void
+record_headless_game(HeadlessStats* stats, Game* game) {
+    ++stats->games;
+    ++stats->deaths[game->game_over_cause];
+    stats->total_score += game->score;
+    stats->path_cache_hits += game->path_cache_hits;
+    stats->path_cache_misses += game->path_cache_misses;
+    stats->tail_chases += game->tail_chases;
+    SNAKE_STAT(merge_hot_path_stats(&stats->hot_path, &game->stats));
+    SNAKE_STAT(clear_hot_path_stats(&game->stats));
+    stats->min_score = min(stats->min_score, game->score);
+    stats->max_score = max(stats->max_score, game->score);
+    ++stats->score_histogram[min(game->score, stats->histogram_size - 1)];
+}
+
+//Plays one game from reset until it ends and adds it to stats.
+static void
+play_headless_game(Game* game, i32 starvation_ticks, HeadlessStats* stats) {
+    reset_state(game);
+    do {
+        game_loop(game);
+        ++stats->ticks;
+    } while(!headless_game_over(game, starvation_ticks));
+    record_headless_game(stats, game);
+}
+
+//NOTE: The lockstep runner plays config->lane_count games at once on one
+//      thread, one per lane, and moves all of them a tick before the next.
+//      Every lane is a whole Game that steers with steer_snake and settles
+//      its move with settle_snake_move, the same rules game_loop follows.
+//      In between, the heads are stepped and checked against the edges and
+//      the fruits for all lanes together. That part only needs the heads,
+//      directions and fruits, which are copied into blocks of
+//      LOCKSTEP_BLOCK_LANES lanes with an array per field, so each block is
+//      a fixed length loop over arrays that can't overlap and the compiler
+//      turns it into vector code.
+#define LOCKSTEP_BLOCK_LANES 8
+
+struct LockstepBlock {
+    i32 head_x[LOCKSTEP_BLOCK_LANES];
+    i32 head_y[LOCKSTEP_BLOCK_LANES];
+    i32 direction[LOCKSTEP_BLOCK_LANES];
+    i32 fruit_x[LOCKSTEP_BLOCK_LANES];
+    i32 fruit_y[LOCKSTEP_BLOCK_LANES];
+    i32 next_x[LOCKSTEP_BLOCK_LANES];
+    i32 next_y[LOCKSTEP_BLOCK_LANES];
+    b32 off_grid[LOCKSTEP_BLOCK_LANES];
+    b32 grows[LOCKSTEP_BLOCK_LANES];
+};
+
+struct LockstepBatch {
+    i32 lane_count;
+    i32 block_count; //The lanes of the last block past lane_count stay idle
+    LockstepBlock* blocks;
+    Game* games;  //One per lane
+    b32* active;  //A game is running in the lane
+    i32 active_count;
+};
+
+static void
+init_lockstep_batch(LockstepBatch* batch, GameConfig* config, i32 lane_count) {
+    batch->lane_count = lane_count;
+    batch->block_count = (lane_count + LOCKSTEP_BLOCK_LANES - 1) / LOCKSTEP_BLOCK_LANES;
+    batch->blocks = (LockstepBlock*)calloc(batch->block_count, sizeof(LockstepBlock));
+    batch->games = new Game[lane_count];
+    batch->active = (b32*)calloc(lane_count, sizeof(b32));
+    batch->active_count = 0;
+    for(i32 lane = 0; lane < lane_count; lane++) {
+        init_game(&batch->games[lane], config);
+    }
+}
+
+static void
+free_lockstep_batch(LockstepBatch* batch) {
+    for(i32 lane = 0; lane < batch->lane_count; lane++) {
+        free_game(&batch->games[lane]);
+    }
+    delete[] batch->games;
+    free(batch->blocks);
+    free(batch->active);
+}
+
+//Copies the head and the fruit of the lane's game into its block.
+inline void
+lockstep_load_lane(LockstepBatch* batch, i32 lane) {
+    Game* game = &batch->games[lane];
+    LockstepBlock* block = &batch->blocks[lane / LOCKSTEP_BLOCK_LANES];
+    i32 index = lane % LOCKSTEP_BLOCK_LANES;
+    Vec2 head = *snake_segment(game, 0);
+    block->head_x[index] = head.x;
+    block->head_y[index] = head.y;
+    block->fruit_x[index] = game->fruit_pos.x;
+    block->fruit_y[index] = game->fruit_pos.y;
+}
+
+static void
+lockstep_start_game(LockstepBatch* batch, i32 lane, u64 seed) {
+    Game* game = &batch->games[lane];
+    seed_game(game, seed);
+    reset_state(game);
+    if(!batch->active[lane]) {
+        batch->active[lane] = true;
+        ++batch->active_count;
+    }
+    lockstep_load_lane(batch, lane);
+}
+
+//Moves the game in every active lane by one tick, the way game_loop does.
+static void
+lockstep_tick(LockstepBatch* batch) {
+    i64 trace_start_ns = trace_begin();
+    i32 lane_count = batch->lane_count;
+    for(i32 lane = 0; lane < lane_count; lane++) {
+        if(batch->active[lane]) {
+            Game* game = &batch->games[lane];
+            SNAKE_STAT(i64 plan_start_ns = stats_get_ns());
+            steer_snake(game);
+            SNAKE_STAT(game->stats.plan_ns += stats_get_ns() - plan_start_ns);
+            batch->blocks[lane / LOCKSTEP_BLOCK_LANES].direction[lane % LOCKSTEP_BLOCK_LANES] = game->direction;
+        }
+    }
+
+    //Idle lanes are stepped too, they just aren't settled
+    SNAKE_STAT(i64 step_start_ns = stats_get_ns());
+    i32 grid_width = batch->games[0].grid_width;
+    i32 grid_height = batch->games[0].grid_height;
+    for(i32 block_index = 0; block_index < batch->block_count; block_index++) {
+        LockstepBlock* block = &batch->blocks[block_index];
+        for(i32 i = 0; i < LOCKSTEP_BLOCK_LANES; i++) {
+            i32 x = block->head_x[i] + direction_dx(block->direction[i]);
+            i32 y = block->head_y[i] + direction_dy(block->direction[i]);
+            block->next_x[i] = x;
+            block->next_y[i] = y;
+            block->off_grid[i] = is_off_grid(x, y, grid_width, grid_height);
+            block->grows[i] = (x == block->fruit_x[i]) & (y == block->fruit_y[i]);
+        }
+    }
+    SNAKE_STAT(i64 step_ns = (stats_get_ns() - step_start_ns) / max(batch->active_count, 1));
+
+    for(i32 lane = 0; lane < lane_count; lane++) {
+        if(batch->active[lane]) {
+            Game* game = &batch->games[lane];
+            LockstepBlock* block = &batch->blocks[lane / LOCKSTEP_BLOCK_LANES];
+            i32 index = lane % LOCKSTEP_BLOCK_LANES;
+            SNAKE_STAT(i64 move_start_ns = stats_get_ns());
+            Vec2 snake_pos = { block->next_x[index], block->next_y[index] };
+            settle_snake_move(game, snake_pos, block->off_grid[index], block->grows[index]);
+            lockstep_load_lane(batch, lane);
+            SNAKE_STAT(game->stats.move_ns += stats_get_ns() - move_start_ns + step_ns);
+            SNAKE_STAT(++game->stats.ticks);
+        }
+    }
+    trace_end("lockstep_tick", trace_start_ns);
+}
+
+//Hands out the seeds of the games a lockstep run plays, returns false when
+//there are none left.
+typedef b32 LockstepPopSeedProc(void* context, u64* seed);
+
+//Plays games in config->lane_count lanes until pop_seed runs dry and adds
+//them to stats.
+static void
+run_lockstep_games(HeadlessConfig* config, LockstepPopSeedProc* pop_seed, void* context, HeadlessStats* stats) {
+    LockstepBatch batch;
+    init_lockstep_batch(&batch, &config->game, config->lane_count);
+    i32 starvation_ticks = headless_starvation_ticks(config);
+
+    u64 seed;
+    for(i32 lane = 0; lane < batch.lane_count && pop_seed(context, &seed); lane++) {
+        lockstep_start_game(&batch, lane, seed);
+    }
+
+    while(batch.active_count > 0) {
+        lockstep_tick(&batch);
+        for(i32 lane = 0; lane < batch.lane_count; lane++) {
+            if(!batch.active[lane]) {
+                continue;
+            }
+            Game* game = &batch.games[lane];
+            ++stats->ticks;
+            if(!headless_game_over(game, starvation_ticks)) {
+                continue;
+            }
+
+            record_headless_game(stats, game);
+            if(pop_seed(context, &seed)) {
+                lockstep_start_game(&batch, lane, seed);
+            } else {
+                batch.active[lane] = false;
+                --batch.active_count;
+            }
+        }
+    }
+
+    free_lockstep_batch(&batch);
+}
+
+struct LockstepSeedCounter {
+    u64 seed;
+    i64 next_game;
+    i64 game_count;
+};
+
+static b32
+lockstep_pop_counted_seed(void* context, u64* seed) {
+    LockstepSeedCounter* counter = (LockstepSeedCounter*)context;
+    if(counter->next_game >= counter->game_count) {
+        return false;
+    }
+    *seed = mix_seed(counter->seed, (u64)counter->next_game++);
+    return true;
+}
+
+//Runs config->game_count games back to back on the calling thread and fills
+//in stats, which must be released with free_headless_stats. Every game is
+//recorded to replay if it isn't 0, which needs config->lane_count 1.
+static void
+run_headless(HeadlessConfig* config, HeadlessStats* stats, ReplayWriter* replay) {
+    init_headless_stats(stats, config->game.grid_width*config->game.grid_height);
+    f64 start_time = headless_get_time();
+    if(config->lane_count > 1) {
+        assert(!replay);
+        LockstepSeedCounter counter = { config->seed, 0, config->game_count };
+        run_lockstep_games(config, lockstep_pop_counted_seed, &counter, stats);
+    } else {
+        Game game;
+        init_game(&game, &config->game);
+        game.replay = replay;
+        i32 starvation_ticks = headless_starvation_ticks(config);
+        for(i64 game_index = 0; game_index < config->game_count; game_index++) {
+            seed_game(&game, mix_seed(config->seed, (u64)game_index));
+            play_headless_game(&game, starvation_ticks, stats);
+        }
+        free_game(&game);
+    }
+    stats->seconds = headless_get_time() - start_time;
+}
+
+//NOTE: The batch runner splits the games over worker threads. Every worker
+//      owns its Game (and with it the pathfinder workspace) and a queue of
+//      game seeds. A worker that runs dry steals from the front of another
+//      worker's queue while the owner keeps popping from the back.
+struct BatchWorkQueue {
+    std::mutex mutex;
+    std::deque<u64> seeds;
+};
+
+struct BatchWorker {
+    BatchWorkQueue queue;
+    HeadlessStats stats;
+};
+
+static b32
+batch_pop_seed(BatchWorker* workers, i32 worker_count, i32 worker_index, u64* seed) {
+    {
+        BatchWorkQueue* own = &workers[worker_index].queue;
+        std::lock_guard<std::mutex> lock(own->mutex);
+        if(!own->seeds.empty()) {
+            *seed = own->seeds.back();
+            own->seeds.pop_back();
+            return true;
+        }
+    }
+
+    for(i32 i = 1; i < worker_count; i++) {
+        BatchWorkQueue* victim = &workers[(worker_index + i) % worker_count].queue;
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if(!victim->seeds.empty()) {
+            *seed = victim->seeds.front();
+            victim->seeds.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+struct BatchSeedSource {
+    BatchWorker* workers;
+    i32 worker_count;
+    i32 worker_index;
+};
+
+static b32
+batch_pop_lockstep_seed(void* context, u64* seed) {
+    BatchSeedSource* source = (BatchSeedSource*)context;
+    return batch_pop_seed(source->workers, source->worker_count, source->worker_index, seed);
+}
+
+static void
+batch_worker_proc(HeadlessConfig* config, BatchWorker* workers, i32 worker_index) {
+    BatchWorker* worker = &workers[worker_index];
+    if(config->lane_count > 1) {
+        BatchSeedSource source = { workers, config->thread_count, worker_index };
+        run_lockstep_games(config, batch_pop_lockstep_seed, &source, &worker->stats);
+        return;
+    }
+
+    Game game;
+    init_game(&game, &config->game);
+    i32 starvation_ticks = headless_starvation_ticks(config);
+
+    u64 seed;
+    while(batch_pop_seed(workers, config->thread_count, worker_index, &seed)) {
+        seed_game(&game, seed);
+        play_headless_game(&game, starvation_ticks, &worker->stats);
+    }
+
+    free_game(&game);
+}
+
+//Same as run_headless but spread over config->thread_count threads.
+static void
+run_headless_batch(HeadlessConfig* config, HeadlessStats* stats) {
+    i32 worker_count = max(config->thread_count, 1);
+    BatchWorker* workers = new BatchWorker[worker_count];
+    i32 cell_count = config->game.grid_width*config->game.grid_height;
+    for(i32 i = 0; i < worker_count; i++) {
+        init_headless_stats(&workers[i].stats, cell_count);
+    }
+    for(i64 game_index = 0; game_index < config->game_count; game_index++) {
+        u64 seed = mix_seed(config->seed, (u64)game_index);
+        workers[game_index % worker_count].queue.seeds.push_back(seed);
+    }
+
+    f64 start_time = headless_get_time();
+    std::vector<std::thread> threads;
+    for(i32 i = 0; i < worker_count; i++) {
+        threads.push_back(std::thread(batch_worker_proc, config, workers, i));
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    init_headless_stats(stats, cell_count);
+    stats->seconds = headless_get_time() - start_time;
+    for(i32 i = 0; i < worker_count; i++) {
+        merge_headless_stats(stats, &workers[i].stats);
+        free_headless_stats(&workers[i].stats);
+    }
+    delete[] workers;
+}
+
+static void
+print_headless_stats(HeadlessConfig* config, HeadlessStats* stats) {
+    f64 seconds = max(stats->seconds, 1e-9);
+    f64 mean_score = stats->games ? (f64)stats->total_score / (f64)stats->games : 0;
+    i32 min_score = stats->games ? stats->min_score : 0;
+    printf("grid:        %dx%d\n", config->game.grid_width, config->game.grid_height);
+    printf("planner:     %s\n", planner_names[config->game.planner]);
+    printf("seed:        %llu\n", (unsigned long long)config->seed);
+    printf("threads:     %d\n", config->thread_count);
+    printf("lanes:       %d\n", config->lane_count);
+    printf("neighbors:   %s\n", walkable_adjacent_mask_version.name);
+    printf("flood fill:  %s\n", flood_fill_expand_version.name);
+    printf("games:       %lld\n", (long long)stats->games);
+    printf("ticks:       %lld\n", (long long)stats->ticks);
+    printf("time:        %.3fs\n", stats->seconds);
+    printf("games/sec:   %.1f\n", stats->games / seconds);
+    printf("ticks/sec:   %.1f\n", stats->ticks / seconds);
+    i64 path_lookups = stats->path_cache_hits + stats->path_cache_misses;
+    printf("path cache:  %lld hits, %lld misses (%.1f%% hits)\n",
+           (long long)stats->path_cache_hits, (long long)stats->path_cache_misses,
+           path_lookups ? 100.0*(f64)stats->path_cache_hits / (f64)path_lookups : 0.0);
+    printf("tail chases: %lld\n", (long long)stats->tail_chases);
+#if SNAKE_STATS
+    char hot_path[256];
+    format_hot_path_stats(hot_path, sizeof(hot_path), &stats->hot_path);
+    printf("hot path:    %s\n", hot_path);
+#endif
+    printf("score:       min %d, mean %.2f, max %d\n", min_score, mean_score, stats->max_score);
+
+    printf("deaths:     ");
+    for(i32 i = GAME_OVER_NONE + 1; i < GAME_OVER_CAUSE_COUNT; i++) {
+        printf(" %s %lld%s", game_over_cause_names[i], (long long)stats->deaths[i],
+               i + 1 < GAME_OVER_CAUSE_COUNT ? "," : "\n");
+    }
+
+    //Print the histogram in at most 10 buckets
+    if(stats->games > 0) {
+        i32 bucket_size = max(1, (stats->max_score - min_score + 10) / 10);
+        printf("histogram:\n");
+        for(i32 bucket_start = min_score; bucket_start <= stats->max_score; bucket_start += bucket_size) {
+            i64 count = 0;
+            i32 bucket_end = min(bucket_start + bucket_size, stats->max_score + 1);
+            for(i32 score = bucket_start; score < bucket_end; score++) {
+                count += stats->score_histogram[score];
+            }
+            printf("  %5d-%-5d %lld\n", bucket_start, bucket_end - 1, (long long)count);
+        }
+    }
+}
+
+//Prints the header of the replay at path and a line per game. Returns false
+//if it isn't a replay this version can read.
+static b32
+print_replay(const char* path) {
+    ReplayHeader header;
+    FILE* file = open_replay(path, &header);
+    if(!file) {
+        return false;
+    }
+
+    i32 grid_width = header.game.grid_width;
+    i32 planner = header.game.planner;
+    printf("seed:        %llu%s\n", (unsigned long long)header.seed,
+           (header.flags & REPLAY_SEED_PER_GAME) ? ", one per game" : "");
+    printf("grid:        %dx%d\n", grid_width, header.game.grid_height);
+    printf("planner:     %s\n", (planner >= 0 && planner < PLANNER_COUNT) ? planner_names[planner] : "unknown");
+    printf("tail safety: %d\n", header.game.tail_safety);
+    printf("tick:        %g, min %g, speed up %g\n",
+           header.game.start_frame_time, header.game.min_frame_time, header.game.speed_up_rate);
+
+    i32 game_count = 0;
+    i64 move_count = 0;
+    i32 fruit_count = 0;
+    b32 in_game = false;
+    b32 valid = true;
+    u8 tag;
+    while(valid && replay_read_bytes(file, &tag, 1)) {
+        u8 bytes[4];
+        switch(tag) {
+            case 'G': {
+                u8 cells[8];
+                valid = replay_read_bytes(file, cells, 8);
+                if(valid) {
+                    if(in_game) {
+                        printf("game %d: %lld moves, %d fruits, unfinished\n", game_count, (long long)move_count, fruit_count);
+                    }
+                    u32 start = replay_get_u32(cells);
+                    ++game_count;
+                    move_count = 0;
+                    fruit_count = 0;
+                    in_game = true;
+                    printf("game %d: starts at %u,%u\n", game_count, start % grid_width, start / grid_width);
+                }
+            }
+            break;
+            case 'M': {
+                u8 moves[REPLAY_RUN_MOVES / 4];
+                valid = replay_read_bytes(file, bytes, 2);
+                i32 count = valid ? ((i32)bytes[0] | ((i32)bytes[1] << 8)) : 0;
+                valid = valid && count <= REPLAY_RUN_MOVES && replay_read_bytes(file, moves, (count + 3) / 4);
+                move_count += count;
+            }
+            break;
+            case 'F': {
+                valid = replay_read_bytes(file, bytes, 4);
+                ++fruit_count;
+            }
+            break;
+            case 'E': {
+                valid = replay_read_bytes(file, bytes, 1);
+                if(valid) {
+                    i32 cause = bytes[0] < GAME_OVER_CAUSE_COUNT ? (i32)bytes[0] : (i32)GAME_OVER_NONE;
+                    printf("game %d: %lld moves, %d fruits, %s\n", game_count, (long long)move_count,
+                           fruit_count, game_over_cause_names[cause]);
+                    in_game = false;
+                }
+            }
+            break;
+            default: {
+                valid = false;
+            }
+            break;
+        }
+    }
+    if(in_game) {
+        printf("game %d: %lld moves, %d fruits, unfinished\n", game_count, (long long)move_count, fruit_count);
+    }
+    if(!valid) {
+        fprintf(stderr, "%s is cut off or damaged after game %d\n", path, game_count);
+    }
+
+    fclose(file);
+    return true;
+}
+
+static const char* direction_names[] = {
+    "up",
+    "down",
+    "left",
+    "right",
+};
+
+//Plays the games in the replay at path again from its seed and checks that
+//every start, move, fruit and game over comes out the same. Prints the
+//first difference. Returns false if there is one or the file can't be read.
+static b32
+verify_replay(const char* path) {
+    ReplayHeader header;
+    FILE* file = open_replay(path, &header);
+    if(!file) {
+        return false;
+    }
+    if(!validate_game_config(&header.game)) {
+        fclose(file);
+        return false;
+    }
+
+    Game game;
+    init_game(&game, &header.game);
+    if(!(header.flags & REPLAY_SEED_PER_GAME)) {
+        seed_game(&game, header.seed);
+    }
+
+    i32 grid_width = game.grid_width;
+    i32 game_count = 0;
+    i64 move_count = 0; //In the current game
+    i64 total_moves = 0;
+    i32 fruit_count = 0;
+    b32 in_game = false;
+    b32 valid = true;
+    b32 matches = true;
+    u8 tag;
+    while(valid && matches && replay_read_bytes(file, &tag, 1)) {
+        if(tag != 'G' && !in_game) {
+            valid = false;
+            break;
+        }
+        switch(tag) {
+            case 'G': {
+                u8 cells[8];
+                valid = !in_game && replay_read_bytes(file, cells, 8);
+                if(valid) {
+                    if(header.flags & REPLAY_SEED_PER_GAME) {
+                        seed_game(&game, mix_seed(header.seed, (u64)game_count));
+                    }
+                    reset_state(&game);
+                    ++game_count;
+                    move_count = 0;
+                    fruit_count = 0;
+                    in_game = true;
+                    Vec2 head = *snake_segment(&game, 0);
+                    u32 start = replay_get_u32(cells);
+                    u32 fruit = replay_get_u32(cells + 4);
+                    if(start != (u32)(head.y*grid_width + head.x) ||
+                       fruit != (u32)(game.fruit_pos.y*grid_width + game.fruit_pos.x))
+                    {
+                        printf("game %d: recorded start %u,%u and fruit %u,%u, replayed %d,%d and %d,%d\n",
+                               game_count, start % grid_width, start / grid_width, fruit % grid_width, fruit / grid_width,
+                               head.x, head.y, game.fruit_pos.x, game.fruit_pos.y);
+                        matches = false;
+                    }
+                }
+            }
+            break;
+            case 'M': {
+                u8 bytes[2];
+                u8 moves[REPLAY_RUN_MOVES / 4];
+                valid = replay_read_bytes(file, bytes, 2);
+                i32 count = valid ? ((i32)bytes[0] | ((i32)bytes[1] << 8)) : 0;
+                valid = valid && count <= REPLAY_RUN_MOVES && replay_read_bytes(file, moves, (count + 3) / 4);
+                for(i32 i = 0; valid && matches && i < count; i++) {
+                    i32 recorded = (moves[i >> 2] >> ((i & 3)*2)) & 3;
+                    ++move_count;
+                    if(game.collided) {
+                        printf("game %d, move %lld: recorded %s, the replayed game was already over\n",
+                               game_count, (long long)move_count, direction_names[recorded]);
+                        matches = false;
+                        break;
+                    }
+                    game_loop(&game);
+                    if(game.direction != recorded) {
+                        printf("game %d, move %lld: recorded %s, replayed %s\n", game_count, (long long)move_count,
+                               direction_names[recorded], direction_names[game.direction]);
+                        matches = false;
+                    }
+                }
+                total_moves += count;
+            }
+            break;
+            case 'F': {
+                u8 bytes[4];
+                valid = replay_read_bytes(file, bytes, 4);
+                if(valid) {
+                    ++fruit_count;
+                    u32 fruit = replay_get_u32(bytes);
+                    if(game.score != fruit_count || fruit != (u32)(game.fruit_pos.y*grid_width + game.fruit_pos.x)) {
+                        printf("game %d, move %lld: recorded fruit %d at %u,%u, replayed fruit %d at %d,%d\n",
+                               game_count, (long long)move_count, fruit_count, fruit % grid_width, fruit / grid_width,
+                               game.score, game.fruit_pos.x, game.fruit_pos.y);
+                        matches = false;
+                    }
+                }
+            }
+            break;
+            case 'E': {
+                u8 cause;
+                valid = replay_read_bytes(file, &cause, 1) && cause < GAME_OVER_CAUSE_COUNT;
+                if(valid) {
+                    //Starving is up to whoever ran the game, the game itself goes on
+                    i32 replayed = game.collided ? game.game_over_cause : (i32)GAME_OVER_STARVED;
+                    //The fruit that fills the board has nowhere to spawn, so no 'F'
+                    i32 score = fruit_count + (cause == GAME_OVER_BOARD_FULL);
+                    if(replayed != cause || game.score != score) {
+                        printf("game %d, move %lld: recorded %s with score %d, replayed %s with %d\n",
+                               game_count, (long long)move_count, game_over_cause_names[cause], score,
+                               game_over_cause_names[replayed], game.score);
+                        matches = false;
+                    }
+                    in_game = false;
+                }
+            }
+            break;
+            default: {
+                valid = false;
+            }
+            break;
+        }
+    }
+    fclose(file);
+    free_game(&game);
+
+    if(!valid) {
+        fprintf(stderr, "%s is cut off or damaged in game %d\n", path, game_count);
+        return false;
+    }
+    if(!matches) {
+        return false;
+    }
+    printf("%s: %d games and %lld moves replay the same%s\n", path, game_count, (long long)total_moves,
+           in_game ? ", the last one unfinished" : "");
+    return true;
+}
+
+static b32
+parse_headless_args(i32 argc, char** argv, HeadlessConfig* config) {
+    for(i32 i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : 0;
+        if(strcmp(arg, "--headless") == 0) {
+            //Only selects this mode
+        } else if(strcmp(arg, "--games") == 0 && value) {
+            config->game_count = atoll(value);
+            ++i;
+        } else if(parse_game_arg(argc, argv, &i, &config->game)) {
+            //Grid size and tick timing
+        } else if(strcmp(arg, "--starvation") == 0 && value) {
+            config->starvation_ticks = atoi(value);
+            ++i;
+        } else if(strcmp(arg, "--seed") == 0 && value) {
+            config->seed = strtoull(value, 0, 10);
+            ++i;
+        } else if(strcmp(arg, "--record") == 0 && value) {
+            config->record_path = value;
+            ++i;
+        } else if(strcmp(arg, "--replay-info") == 0 && value) {
+            config->replay_path = value;
+            ++i;
+        } else if(strcmp(arg, "--verify-replay") == 0 && value) {
+            config->verify_path = value;
+            ++i;
+        } else if(strcmp(arg, "--trace") == 0 && value) {
+            config->trace_path = value;
+            ++i;
+        } else if(strcmp(arg, "--lanes") == 0 && value) {
+            config->lane_count = max(atoi(value), 1);
+            ++i;
+        } else if(strcmp(arg, "--threads") == 0 && value) {
+            config->thread_count = atoi(value);
+            if(config->thread_count <= 0) {
+                config->thread_count = max((i32)std::thread::hardware_concurrency(), 1);
+            }
+            ++i;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    if(config->record_path && (config->thread_count > 1 || config->lane_count > 1)) {
+        //One file takes the games in order
+        fprintf(stderr, "--record needs --threads 1 and --lanes 1\n");
+        return false;
+    }
+    return validate_game_config(&config->game);
+}
+
+static i32
+headless_main(i32 argc, char** argv) {
+    HeadlessConfig config;
+    default_headless_config(&config);
+    if(!parse_headless_args(argc, argv, &config)) {
+        fprintf(stderr, "Usage: %s [--headless] [--games N] [--grid N | --grid-width N --grid-height N] "
+                        "[--tick S] [--min-tick S] [--speed-up RATE] [--planner astar|jps|dstar|timed|hamilton|bfs] "
+                        "[--tail-safety 0|1] [--starvation TICKS] "
+                        "[--threads N, 0 = all cores] [--lanes N] [--seed N] [--trace FILE] [--record FILE] "
+                        "[--replay-info FILE] [--verify-replay FILE]\n", argv[0]);
+        return 1;
+    }
+
+    if(config.replay_path) {
+        return print_replay(config.replay_path) ? 0 : 1;
+    }
+    if(config.verify_path) {
+        return verify_replay(config.verify_path) ? 0 : 1;
+    }
+    ReplayWriter* replay = 0;
+    if(config.record_path) {
+        replay = start_replay(config.record_path, &config.game, config.seed, REPLAY_SEED_PER_GAME);
+        if(!replay) {
+            return 1;
+        }
+    }
+    if(config.trace_path && !start_tracing(config.trace_path)) {
+        return 1;
+    }
+    HeadlessStats stats;
+    if(config.thread_count > 1) {
+        run_headless_batch(&config, &stats);
+    } else {
+        run_headless(&config, &stats, replay);
+    }
+    stop_tracing();
+    if(replay) {
+        finish_replay(replay);
+    }
+    print_headless_stats(&config, &stats);
+    free_headless_stats(&stats);
+    return 0;
+}
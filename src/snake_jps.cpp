@@ -0,0 +1,196 @@
+//NOTE: Jump Point Search for the 4-connected grid. Uses the same workspace,
+//      heap and node index as find_path_with_astar but only puts jump points
+//      into the open set.
+//
+//      Canonical paths move horizontally and only turn vertically where a
+//      vertical scan finds something, so:
+//       -A horizontal jump stops on a cell from which a vertical jump (up or
+//        down) reaches a jump point.
+//       -A vertical jump stops on the goal or a forced neighbor, a side cell
+//        that is open while the cell behind it was blocked.
+
+inline b32
+jps_walkable(Occupancy* occupancy, i32 x, i32 y) {
+    if(x < 0 || y < 0 || x >= occupancy->grid_width || y >= occupancy->grid_height) {
+        return false;
+    }
+    Vec2 pos = { x, y };
+    return check_walkable_cell(pos, occupancy);
+}
+
+inline b32
+jps_has_forced_neighbor(Occupancy* occupancy, Vec2 pos, i32 dy) {
+    return (jps_walkable(occupancy, pos.x - 1, pos.y) && !jps_walkable(occupancy, pos.x - 1, pos.y - dy)) ||
+           (jps_walkable(occupancy, pos.x + 1, pos.y) && !jps_walkable(occupancy, pos.x + 1, pos.y - dy));
+}
+
+static b32
+jps_jump_vertical(Occupancy* occupancy, Vec2 pos, i32 dy, Vec2 goal, Vec2* jump_point) {
+    for(;;) {
+        pos.y += dy;
+        if(!jps_walkable(occupancy, pos.x, pos.y)) {
+            return false;
+        }
+        if(pos == goal || jps_has_forced_neighbor(occupancy, pos, dy)) {
+            *jump_point = pos;
+            return true;
+        }
+    }
+}
+
+static b32
+jps_jump_horizontal(Occupancy* occupancy, Vec2 pos, i32 dx, Vec2 goal, Vec2* jump_point) {
+    Vec2 unused;
+    for(;;) {
+        pos.x += dx;
+        if(!jps_walkable(occupancy, pos.x, pos.y)) {
+            return false;
+        }
+        if(pos == goal ||
+           jps_jump_vertical(occupancy, pos, 1, goal, &unused) ||
+           jps_jump_vertical(occupancy, pos, -1, goal, &unused))
+        {
+            *jump_point = pos;
+            return true;
+        }
+    }
+}
+
+inline i32
+jps_sign(i32 value) {
+    return (value > 0) - (value < 0);
+}
+
+//Fills in the straight runs between jump points so the path has one entry
+//per cell, like the one find_path_with_astar returns.
+static i32
+jps_reconstruct_path(AstarCell* goal, Vec2* path) {
+    i32 count = goal->score.G + 1;
+    i32 index = count;
+    path[--index] = goal->position;
+    for(AstarCell* current = goal; current->previous != 0; current = current->previous) {
+        Vec2 from = current->previous->position;
+        Vec2 pos = current->position;
+        i32 dx = jps_sign(from.x - pos.x);
+        i32 dy = jps_sign(from.y - pos.y);
+        while(pos != from) {
+            pos.x += dx;
+            pos.y += dy;
+            path[--index] = pos;
+        }
+    }
+    assert(index == 0);
+    return count;
+}
+
+//Same contract as find_path_with_astar. An unreachable goal is handed to
+//it, the jump points found may not go past the start even when the head
+//has free neighbors.
+static i32
+find_path_with_jps(PathfinderWorkspace* workspace, Vec2 start, Vec2 goal,
+      Occupancy* occupancy)
+{
+    i32 grid_width = occupancy->grid_width;
+    assert(workspace->max_count == grid_width*occupancy->grid_height);
+    AstarCell* cells = workspace->cells;
+    i32 cell_counter = 0;
+
+    AstarOpenHeap* open_set = &workspace->open_set;
+    open_set->count = 0;
+
+    AstarNodeIndex* node_index = &workspace->node_index;
+    astar_node_index_begin_search(node_index);
+
+    AstarNodeIndexEntry* start_entry = astar_node_index_get(node_index, start, grid_width);
+    start_entry->slot = cell_counter;
+    start_entry->state = ASTAR_NODE_OPEN;
+
+    AstarCell* current_cell = &cells[cell_counter++];
+    current_cell->position = start;
+    current_cell->score.G = 0;
+    current_cell->score.H = astar_heuristic(start, goal);
+    current_cell->previous = 0;
+
+    astar_heap_push(open_set, current_cell);
+
+    do {
+        current_cell = astar_heap_pop(open_set);
+        astar_node_index_get(node_index, current_cell->position, grid_width)->state = ASTAR_NODE_CLOSED;
+
+        Vec2 pos = current_cell->position;
+        if(pos == goal) {
+            //Found path
+            break;
+        }
+
+        //Prune the directions by the way we came in
+        i32 dx = 0;
+        i32 dy = 0;
+        if(current_cell->previous) {
+            dx = jps_sign(pos.x - current_cell->previous->position.x);
+            dy = jps_sign(pos.y - current_cell->previous->position.y);
+        }
+
+        Vec2 jump_points[4];
+        i32 jump_point_count = 0;
+        Vec2 jump_point;
+        if(dx == 0 && dy == 0) {
+            //Start cell, everything is open
+            if(jps_jump_horizontal(occupancy, pos, -1, goal, &jump_point)) jump_points[jump_point_count++] = jump_point;
+            if(jps_jump_horizontal(occupancy, pos,  1, goal, &jump_point)) jump_points[jump_point_count++] = jump_point;
+            if(jps_jump_vertical(occupancy, pos, -1, goal, &jump_point))   jump_points[jump_point_count++] = jump_point;
+            if(jps_jump_vertical(occupancy, pos,  1, goal, &jump_point))   jump_points[jump_point_count++] = jump_point;
+        } else if(dx != 0) {
+            if(jps_jump_horizontal(occupancy, pos, dx, goal, &jump_point)) jump_points[jump_point_count++] = jump_point;
+            if(jps_jump_vertical(occupancy, pos, -1, goal, &jump_point))   jump_points[jump_point_count++] = jump_point;
+            if(jps_jump_vertical(occupancy, pos,  1, goal, &jump_point))   jump_points[jump_point_count++] = jump_point;
+        } else {
+            if(jps_jump_vertical(occupancy, pos, dy, goal, &jump_point)) {
+                jump_points[jump_point_count++] = jump_point;
+            }
+            for(i32 side = -1; side <= 1; side += 2) {
+                if(jps_walkable(occupancy, pos.x + side, pos.y) &&
+                   !jps_walkable(occupancy, pos.x + side, pos.y - dy) &&
+                   jps_jump_horizontal(occupancy, pos, side, goal, &jump_point))
+                {
+                    jump_points[jump_point_count++] = jump_point;
+                }
+            }
+        }
+
+        for(i32 i = 0; i < jump_point_count; i++) {
+            Vec2 next = jump_points[i];
+            AstarNodeIndexEntry* entry = astar_node_index_get(node_index, next, grid_width);
+            if(entry->state == ASTAR_NODE_CLOSED) {
+                continue;
+            }
+
+            i32 G = current_cell->score.G + astar_heuristic(pos, next);
+            if(entry->state == ASTAR_NODE_UNSEEN) {
+                entry->slot = cell_counter;
+                entry->state = ASTAR_NODE_OPEN;
+                AstarCell* cell = &cells[cell_counter++];
+                cell->position = next;
+                cell->score.G = G;
+                cell->score.H = astar_heuristic(next, goal);
+                cell->previous = current_cell;
+                astar_heap_push(open_set, cell);
+            } else {
+                AstarCell* found_cell = &cells[entry->slot];
+                if(G < found_cell->score.G) {
+                    found_cell->previous = current_cell;
+                    found_cell->score.G = G;
+                    astar_heap_decrease_key(open_set, found_cell);
+                }
+            }
+        }
+
+    } while(open_set->count > 0);
+
+    if(current_cell->position != goal) {
+        return find_path_with_astar(workspace, start, goal, occupancy, false);
+    }
+
+    workspace->path_count = jps_reconstruct_path(current_cell, workspace->path);
+    return workspace->path_count;
+}
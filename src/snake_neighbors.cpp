@@ -0,0 +1,143 @@
+//NOTE: Walkability of the four cells next to a position, as a mask with bit
+//      i set for adjacent_offsets[i]. This is the innermost step of the
+//      planners so there is one version per instruction set, picked once at
+//      startup:
+//       -scalar: checks the candidates one by one
+//       -sse2:   bounds checks all four lanes at once, loads the occupancy
+//                words one by one since SSE2 can't gather
+//       -avx2:   also gathers the four occupancy words and tests their bits
+//                in one go
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SNAKE_X86 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SNAKE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SNAKE_TARGET(isa)
+#endif
+
+//Up, left, right, down, the order A* has always tried them in
+static const Vec2 adjacent_offsets[4] = { { 0, 1 }, { -1, 0 }, { 1, 0 }, { 0, -1 } };
+
+inline u32
+adjacent_cells_on_grid(Vec2 pos, i32 grid_width, i32 grid_height) {
+    return (u32)(pos.y + 1 < grid_height) |
+           (u32)(pos.x > 0) << 1 |
+           (u32)(pos.x + 1 < grid_width) << 2 |
+           (u32)(pos.y > 0) << 3;
+}
+
+inline u32
+occupancy_bit(Occupancy* occupancy, i32 cell) {
+    return (u32)(occupancy->words[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static u32
+walkable_adjacent_mask_scalar(Vec2 pos, Occupancy* occupancy) {
+    i32 grid_width = occupancy->grid_width;
+    i32 cell = pos.y*grid_width + pos.x;
+    i32 cells[4] = { cell + grid_width, cell - 1, cell + 1, cell - grid_width };
+    u32 on_grid = adjacent_cells_on_grid(pos, grid_width, occupancy->grid_height);
+    u32 mask = 0;
+    for(i32 i = 0; i < 4; i++) {
+        if((on_grid >> i) & 1) {
+            mask |= (occupancy_bit(occupancy, cells[i]) ^ 1) << i;
+        }
+    }
+    return mask;
+}
+
+#ifdef SNAKE_X86
+//Lanes that are on the grid are all ones, the cells of the other lanes are
+//zeroed so loading them stays in bounds.
+SNAKE_TARGET("sse2") inline __m128i
+adjacent_cells_sse2(Vec2 pos, Occupancy* occupancy, __m128i* cells) {
+    i32 grid_width = occupancy->grid_width;
+    __m128i x = _mm_add_epi32(_mm_set1_epi32(pos.x), _mm_setr_epi32(0, -1, 1, 0));
+    __m128i y = _mm_add_epi32(_mm_set1_epi32(pos.y), _mm_setr_epi32(1, 0, 0, -1));
+    __m128i minus_one = _mm_set1_epi32(-1);
+    __m128i x_on_grid = _mm_and_si128(_mm_cmpgt_epi32(x, minus_one),
+                                      _mm_cmplt_epi32(x, _mm_set1_epi32(grid_width)));
+    __m128i y_on_grid = _mm_and_si128(_mm_cmpgt_epi32(y, minus_one),
+                                      _mm_cmplt_epi32(y, _mm_set1_epi32(occupancy->grid_height)));
+    __m128i on_grid = _mm_and_si128(x_on_grid, y_on_grid);
+    __m128i offsets = _mm_setr_epi32(grid_width, -1, 1, -grid_width);
+    *cells = _mm_and_si128(_mm_add_epi32(_mm_set1_epi32(pos.y*grid_width + pos.x), offsets), on_grid);
+    return on_grid;
+}
+
+SNAKE_TARGET("sse2") static u32
+walkable_adjacent_mask_sse2(Vec2 pos, Occupancy* occupancy) {
+    __m128i cells;
+    u32 on_grid = (u32)_mm_movemask_ps(_mm_castsi128_ps(adjacent_cells_sse2(pos, occupancy, &cells)));
+    i32 lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, cells);
+    u32 occupied = occupancy_bit(occupancy, lanes[0]) |
+                   occupancy_bit(occupancy, lanes[1]) << 1 |
+                   occupancy_bit(occupancy, lanes[2]) << 2 |
+                   occupancy_bit(occupancy, lanes[3]) << 3;
+    return on_grid & ~occupied;
+}
+
+SNAKE_TARGET("avx2") static u32
+walkable_adjacent_mask_avx2(Vec2 pos, Occupancy* occupancy) {
+    __m128i cells;
+    u32 on_grid = (u32)_mm_movemask_ps(_mm_castsi128_ps(adjacent_cells_sse2(pos, occupancy, &cells)));
+    __m256i words = _mm256_i32gather_epi64((const long long*)occupancy->words, _mm_srli_epi32(cells, 6), 8);
+    __m256i shifts = _mm256_cvtepi32_epi64(_mm_and_si128(cells, _mm_set1_epi32(63)));
+    //Move each cell's bit up to the sign bit of its lane
+    __m256i bits = _mm256_slli_epi64(_mm256_srlv_epi64(words, shifts), 63);
+    u32 occupied = (u32)_mm256_movemask_pd(_mm256_castsi256_pd(bits));
+    return on_grid & ~occupied;
+}
+
+static b32
+cpu_supports_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    i32 info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    b32 os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+typedef u32 WalkableAdjacentMaskProc(Vec2 pos, Occupancy* occupancy);
+
+struct WalkableAdjacentMaskVersion {
+    const char* name;
+    WalkableAdjacentMaskProc* proc;
+};
+
+static WalkableAdjacentMaskVersion
+pick_walkable_adjacent_mask_version() {
+    WalkableAdjacentMaskVersion version = { "scalar", walkable_adjacent_mask_scalar };
+#ifdef SNAKE_X86
+    if(cpu_supports_avx2()) {
+        version.name = "avx2";
+        version.proc = walkable_adjacent_mask_avx2;
+    } else {
+        version.name = "sse2";
+        version.proc = walkable_adjacent_mask_sse2;
+    }
+#endif
+    return version;
+}
+
+static WalkableAdjacentMaskVersion walkable_adjacent_mask_version = pick_walkable_adjacent_mask_version();
+
+//Bit i is set if the cell at adjacent_offsets[i] from pos is on the grid and
+//free.
+inline u32
+find_walkable_adjacent_cells(Vec2 pos, Occupancy* occupancy) {
+    return walkable_adjacent_mask_version.proc(pos, occupancy);
+}
@@ -0,0 +1,52 @@
+//NOTE: PCG32 (pcg-random.org). Small, fast and every Game has its own, so
+//      games are reproducible from their seed no matter which thread runs them.
+
+inline u32
+random_next(Rng* rng) {
+    u64 old_state = rng->state;
+    rng->state = old_state*6364136223846793005ULL + rng->increment;
+    u32 xorshifted = (u32)(((old_state >> 18) ^ old_state) >> 27);
+    u32 rotation = (u32)(old_state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((0u - rotation) & 31));
+}
+
+static void
+seed_random(Rng* rng, u64 seed) {
+    rng->state = 0;
+    rng->increment = (seed << 1) | 1;
+    random_next(rng);
+    rng->state += seed;
+    random_next(rng);
+}
+
+//Uniform in [0, bound), without the bias of a plain modulo.
+inline u32
+random_below(Rng* rng, u32 bound) {
+    assert(bound > 0);
+    u64 m = (u64)random_next(rng) * (u64)bound;
+    u32 low = (u32)m;
+    if(low < bound) {
+        u32 threshold = (0u - bound) % bound;
+        while(low < threshold) {
+            m = (u64)random_next(rng) * (u64)bound;
+            low = (u32)m;
+        }
+    }
+    return (u32)(m >> 32);
+}
+
+//splitmix64 finalizer, turns a base seed and a game number into a well mixed seed.
+inline u64
+mix_seed(u64 seed, u64 index) {
+    u64 z = seed + (index + 1)*0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+//Seed to use when none was given on the command line.
+static u64
+default_random_seed() {
+    u64 clock = (u64)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    return mix_seed((u64)time(0), clock);
+}
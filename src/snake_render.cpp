@@ -0,0 +1,231 @@
+//NOTE: Draws a game with an SDL renderer. Used by the window and the render
+//      benchmarks, expects SDL to be included first.
+
+struct Rendering {
+    i32 screen_width;
+    i32 screen_height;
+    i32 cell_width;
+    i32 cell_height;
+    i32 fruit_radius;
+    SDL_Rect* rects;
+    b32 draw_snake;
+    SDL_Texture* grid_texture;
+    SDL_Texture* circle_texture;
+    //NOTE: When cells get too small for rects and grid lines the board is
+    //      drawn into a texture with one texel per cell that gets scaled
+    //      to the window instead.
+    b32 pixel_mode;
+    SDL_Texture* pixel_texture;
+    u32* pixels;
+};
+
+//Smallest cell size in pixels that still gets drawn with rects and grid lines
+#define MIN_RECT_CELL_SIZE 4
+#define DEFAULT_WINDOW_SIZE 768
+//Larger fruits get the circle texture scaled up instead of drawn bigger
+#define MAX_CIRCLE_TEXTURE_RADIUS 64
+
+static f32
+distance(Vec2 a, Vec2 b) {
+    f32 diff_x = b.x - a.x;
+    f32 diff_y = b.y - a.y;
+    f32 result = sqrt(diff_x*diff_x + diff_y*diff_y);
+    return result;
+}
+
+static void
+render_grid(SDL_Renderer *renderer, Rendering* rendering) {
+    const i32 k = 64;
+    SDL_SetRenderDrawColor(renderer, k, k, k, 128);
+    for(i32 i = rendering->cell_width; i < rendering->screen_width; i+=rendering->cell_width) {
+        SDL_RenderDrawLine(renderer, i, 0, i, rendering->screen_height);
+        SDL_RenderDrawLine(renderer, i-1, 0, i-1, rendering->screen_height);
+    }
+    for(i32 i = rendering->cell_height; i < rendering->screen_height; i+=rendering->cell_height) {
+        SDL_RenderDrawLine(renderer, 0, i, rendering->screen_width, i);
+        SDL_RenderDrawLine(renderer, 0, i-1, rendering->screen_width, i-1);
+    }
+}
+
+static void
+render_circle(SDL_Renderer *renderer, i32 px, i32 py, i32 radius) {
+    Vec2 cur_pos;
+    Vec2 center = {px + radius, py + radius};
+
+    i32 side = radius*2 + 1;
+    i32 point_count = 0;
+    SDL_Point* point_buffer = (SDL_Point*)calloc(side*side, sizeof(SDL_Point));
+
+    for(i32 x = 0; x < side; x++) {
+        for(i32 y = 0; y < side; y++) {
+            cur_pos.x = x + px;
+            cur_pos.y = y + py;
+            i32 dist = distance(cur_pos, center);
+            if(dist <= radius) {
+                auto* point = &point_buffer[point_count];
+                point->x = cur_pos.x;
+                point->y = cur_pos.y;
+                ++point_count;
+            }
+        }
+    }
+
+    SDL_RenderDrawPoints(renderer, point_buffer, point_count);
+
+    free(point_buffer);
+}
+
+static void
+reset_routine(Game* game, Rendering* rendering) {
+    game->frame_time = game->start_frame_time;
+    if(game->flash_counter < game->flash_count) {
+        if(game->flash_counter % 2 == 0) {
+            rendering->draw_snake = false;
+        } else {
+            rendering->draw_snake = true;
+        }
+
+        ++game->flash_counter;
+    } else {
+        reset_state(game);
+        rendering->draw_snake = true;
+    }
+}
+
+static void
+render_pixels(SDL_Renderer* renderer, Rendering* rendering, Game* game) {
+    const u32 empty_color = 0xFF000000;
+    const u32 filled_color = 0xFFFFFFFF;
+    u32 snake_color = rendering->draw_snake ? filled_color : empty_color;
+
+    i32 grid_width = game->grid_width;
+    i32 grid_height = game->grid_height;
+    u64* words = game->occupancy.words;
+    for(i32 y = 0; y < grid_height; y++) {
+        //Texture rows go down, game rows go up
+        u32* row = rendering->pixels + (grid_height - y - 1)*grid_width;
+        i32 bit = y*grid_width;
+        for(i32 x = 0; x < grid_width; x++, bit++) {
+            row[x] = ((words[bit >> 6] >> (bit & 63)) & 1) ? snake_color : empty_color;
+        }
+    }
+    rendering->pixels[(grid_height - game->fruit_pos.y - 1)*grid_width + game->fruit_pos.x] = filled_color;
+
+    SDL_UpdateTexture(rendering->pixel_texture, 0, rendering->pixels, grid_width*sizeof(u32));
+    SDL_RenderCopy(renderer, rendering->pixel_texture, 0, 0);
+    i64 trace_start_ns = trace_begin();
+    SDL_RenderPresent(renderer);
+    trace_end("SDL_RenderPresent", trace_start_ns);
+}
+
+void
+render_loop(SDL_Renderer* renderer, Rendering* rendering, Game* game) {
+    if(rendering->pixel_mode) {
+        render_pixels(renderer, rendering, game);
+        return;
+    }
+
+    for(i32 i = 0; i < game->snake_cell_count; i++) {
+        auto* rect = &rendering->rects[i];
+        auto* position = snake_segment(game, i);
+        rect->x = position->x * rendering->cell_width;
+        rect->y = (game->grid_height - position->y - 1) * rendering->cell_height;
+    }
+
+    SDL_RenderCopy(renderer, rendering->grid_texture, 0, 0);
+
+    {
+        const i32 k = 255;
+        SDL_SetRenderDrawColor(renderer, k, k, k, 255);
+    }
+
+    //Draw fruit
+    {
+        SDL_Rect circle_rect;
+        circle_rect.w = rendering->fruit_radius*2;
+        circle_rect.h = rendering->fruit_radius*2;
+        circle_rect.x = (game->fruit_pos.x * rendering->cell_width) +
+                        (rendering->cell_width - circle_rect.w)/2;
+        circle_rect.y = ((game->grid_height-game->fruit_pos.y-1) * rendering->cell_height) +
+                        (rendering->cell_height - circle_rect.h)/2;
+        SDL_RenderCopy(renderer, rendering->circle_texture, 0, &circle_rect);
+    }
+
+    if (rendering->draw_snake) {
+        SDL_RenderFillRects(renderer, rendering->rects, game->snake_cell_count);
+    }
+
+    i64 trace_start_ns = trace_begin();
+    SDL_RenderPresent(renderer);
+    trace_end("SDL_RenderPresent", trace_start_ns);
+}
+
+static void
+init_rendering(Rendering* rendering, Game* game, i32 screen_width, i32 screen_height) {
+    rendering->screen_width = screen_width;
+    rendering->screen_height = screen_height;
+    rendering->cell_width = screen_width / game->grid_width;
+    rendering->cell_height = screen_height / game->grid_height;
+    rendering->draw_snake = true;
+    rendering->rects = 0;
+    rendering->pixels = 0;
+    rendering->pixel_texture = 0;
+    rendering->grid_texture = 0;
+    rendering->circle_texture = 0;
+
+    rendering->pixel_mode = min(rendering->cell_width, rendering->cell_height) < MIN_RECT_CELL_SIZE;
+    if(rendering->pixel_mode) {
+        rendering->fruit_radius = 0;
+        rendering->pixels = (u32*)calloc(game->max_cell_count, sizeof(u32));
+    } else {
+        rendering->fruit_radius = max(1, (min(rendering->cell_width, rendering->cell_height)/2) - 3);
+        rendering->rects = (SDL_Rect*)calloc(game->max_cell_count, sizeof(SDL_Rect));
+        for(i32 i = 0; i < game->max_cell_count; i++) {
+            rendering->rects[i].w = rendering->cell_width;
+            rendering->rects[i].h = rendering->cell_height;
+        }
+    }
+}
+
+//Picks a window that gives square cells, at most DEFAULT_WINDOW_SIZE wide or high.
+static void
+default_window_size(GameConfig* config, i32* width, i32* height) {
+    i32 longest_side = max(config->grid_width, config->grid_height);
+    i32 cell_size = min(32, DEFAULT_WINDOW_SIZE / longest_side);
+    if(cell_size >= 1) {
+        *width = config->grid_width*cell_size;
+        *height = config->grid_height*cell_size;
+    } else {
+        *width = max(1, (i32)((i64)config->grid_width*DEFAULT_WINDOW_SIZE / longest_side));
+        *height = max(1, (i32)((i64)config->grid_height*DEFAULT_WINDOW_SIZE / longest_side));
+    }
+}
+
+void
+init_renderer(SDL_Renderer* renderer, Rendering* rendering, Game* game) {
+    if(rendering->pixel_mode) {
+        rendering->pixel_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                     SDL_TEXTUREACCESS_STREAMING,
+                                                     game->grid_width, game->grid_height);
+        return;
+    }
+
+    SDL_Surface* grid_surface = SDL_CreateRGBSurface(0, rendering->screen_width, rendering->screen_height, 32, 0, 0, 0, 0);
+    SDL_Renderer* grid_renderer = SDL_CreateSoftwareRenderer(grid_surface);
+    render_grid(grid_renderer, rendering);
+    rendering->grid_texture = SDL_CreateTextureFromSurface(renderer, grid_surface);
+    SDL_DestroyRenderer(grid_renderer);
+    SDL_FreeSurface(grid_surface);
+
+    i32 circle_radius = min(rendering->fruit_radius, MAX_CIRCLE_TEXTURE_RADIUS);
+    SDL_Surface* circle_surface =
+        SDL_CreateRGBSurface(0, circle_radius*2+1, circle_radius*2+1, 32, 0, 0, 0, 0);
+    SDL_Renderer* circle_renderer = SDL_CreateSoftwareRenderer(circle_surface);
+    SDL_SetRenderDrawColor(circle_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(circle_renderer);
+    SDL_SetRenderDrawColor(circle_renderer, 255, 255, 255, 255);
+    render_circle(circle_renderer, 0, 0, circle_radius);
+    rendering->circle_texture = SDL_CreateTextureFromSurface(renderer, circle_surface);
+    SDL_DestroyRenderer(circle_renderer);
+    SDL_FreeSurface(circle_surface);
+}
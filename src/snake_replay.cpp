@@ -0,0 +1,228 @@
+//NOTE: Replay files. Everything is little endian. The header is 56 bytes:
+//
+//        0  "SNKR"
+//        4  u16 version (REPLAY_VERSION)
+//        6  u16 flags, REPLAY_SEED_PER_GAME or zero
+//        8  u64 seed
+//       16  i32 grid width, i32 grid height, i32 planner, i32 tail safety
+//       32  f64 start frame time, f64 min frame time, f64 speed up rate
+//
+//      Records follow, each starts with its tag byte:
+//
+//       'G' u32 start cell, u32 fruit cell    A game starts
+//       'M' u16 count, (count + 3)/4 bytes     count moves, 2 bits each, as
+//                                              Direction, lowest bits first
+//       'F' u32 fruit cell                     The fruit was eaten, the new
+//                                              one spawns there
+//       'E' u8 GameOverCause                   The game ended
+//
+//      Without REPLAY_SEED_PER_GAME the games follow each other the way the
+//      window plays them: seed_game once with the seed, then reset_state for
+//      every game. With it, game n starts with seed_game(mix_seed(seed, n))
+//      like the headless runs.
+//
+//      Cells are y*grid width + x. The moves between two other records are
+//      written as one or more 'M' records of at most REPLAY_RUN_MOVES each.
+//      A file cut off by a crash ends after the last complete record.
+//
+//      Recording a move only sets two bits in memory, the records are
+//      written out in REPLAY_BUFFER_SIZE blocks.
+
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 56
+#define REPLAY_SEED_PER_GAME 1
+
+static void
+flush_replay_buffer(ReplayWriter* writer) {
+    if(writer->buffer_count > 0) {
+        fwrite(writer->buffer, 1, writer->buffer_count, writer->file);
+        writer->buffer_count = 0;
+    }
+}
+
+static void
+replay_write_bytes(ReplayWriter* writer, const void* data, i32 size) {
+    if(writer->buffer_count + size > REPLAY_BUFFER_SIZE) {
+        flush_replay_buffer(writer);
+    }
+    memcpy(writer->buffer + writer->buffer_count, data, size);
+    writer->buffer_count += size;
+}
+
+static void
+replay_write_u8(ReplayWriter* writer, u8 value) {
+    replay_write_bytes(writer, &value, 1);
+}
+
+static void
+replay_write_u16(ReplayWriter* writer, u16 value) {
+    u8 bytes[2] = { (u8)value, (u8)(value >> 8) };
+    replay_write_bytes(writer, bytes, 2);
+}
+
+static void
+replay_write_u32(ReplayWriter* writer, u32 value) {
+    u8 bytes[4] = { (u8)value, (u8)(value >> 8), (u8)(value >> 16), (u8)(value >> 24) };
+    replay_write_bytes(writer, bytes, 4);
+}
+
+static void
+replay_write_u64(ReplayWriter* writer, u64 value) {
+    replay_write_u32(writer, (u32)value);
+    replay_write_u32(writer, (u32)(value >> 32));
+}
+
+static void
+replay_write_f64(ReplayWriter* writer, f64 value) {
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    replay_write_u64(writer, bits);
+}
+
+//Writes the moves recorded since the last record as an 'M' record.
+static void
+flush_replay_moves(ReplayWriter* writer) {
+    if(writer->move_count == 0) {
+        return;
+    }
+    i32 byte_count = (writer->move_count + 3) / 4;
+    replay_write_u8(writer, 'M');
+    replay_write_u16(writer, (u16)writer->move_count);
+    replay_write_bytes(writer, writer->moves, byte_count);
+    memset(writer->moves, 0, byte_count);
+    writer->move_count = 0;
+}
+
+//Creates the file at path and writes the header. Returns 0 if the file can't
+//be created, otherwise a writer to set as Game::replay and to pass to
+//finish_replay when done.
+static ReplayWriter*
+start_replay(const char* path, GameConfig* config, u64 seed, u32 flags) {
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        fprintf(stderr, "Can't write %s\n", path);
+        return 0;
+    }
+
+    ReplayWriter* writer = (ReplayWriter*)calloc(1, sizeof(ReplayWriter));
+    writer->file = file;
+    writer->grid_width = config->grid_width;
+    replay_write_bytes(writer, "SNKR", 4);
+    replay_write_u16(writer, REPLAY_VERSION);
+    replay_write_u16(writer, (u16)flags);
+    replay_write_u64(writer, seed);
+    replay_write_u32(writer, (u32)config->grid_width);
+    replay_write_u32(writer, (u32)config->grid_height);
+    replay_write_u32(writer, (u32)config->planner);
+    replay_write_u32(writer, (u32)config->tail_safety);
+    replay_write_f64(writer, config->start_frame_time);
+    replay_write_f64(writer, config->min_frame_time);
+    replay_write_f64(writer, config->speed_up_rate);
+    return writer;
+}
+
+static void
+finish_replay(ReplayWriter* writer) {
+    flush_replay_moves(writer);
+    flush_replay_buffer(writer);
+    fclose(writer->file);
+    free(writer);
+}
+
+inline void
+record_replay_move(ReplayWriter* writer, i32 direction) {
+    i32 index = writer->move_count++;
+    writer->moves[index >> 2] |= (u8)(direction << ((index & 3)*2));
+    if(writer->move_count == REPLAY_RUN_MOVES) {
+        flush_replay_moves(writer);
+    }
+}
+
+static void
+record_replay_start(ReplayWriter* writer, Vec2 start, Vec2 fruit) {
+    flush_replay_moves(writer);
+    replay_write_u8(writer, 'G');
+    replay_write_u32(writer, (u32)(start.y*writer->grid_width + start.x));
+    replay_write_u32(writer, (u32)(fruit.y*writer->grid_width + fruit.x));
+}
+
+static void
+record_replay_fruit(ReplayWriter* writer, Vec2 fruit) {
+    flush_replay_moves(writer);
+    replay_write_u8(writer, 'F');
+    replay_write_u32(writer, (u32)(fruit.y*writer->grid_width + fruit.x));
+}
+
+//Also pushes everything so far to the file, a game that ended is never lost.
+static void
+record_replay_end(ReplayWriter* writer, i32 game_over_cause) {
+    flush_replay_moves(writer);
+    replay_write_u8(writer, 'E');
+    replay_write_u8(writer, (u8)game_over_cause);
+    flush_replay_buffer(writer);
+    fflush(writer->file);
+}
+
+static b32
+replay_read_bytes(FILE* file, void* data, i32 size) {
+    return fread(data, 1, size, file) == (size_t)size;
+}
+
+static u32
+replay_get_u32(u8* bytes) {
+    return (u32)bytes[0] | ((u32)bytes[1] << 8) | ((u32)bytes[2] << 16) | ((u32)bytes[3] << 24);
+}
+
+static u64
+replay_get_u64(u8* bytes) {
+    return (u64)replay_get_u32(bytes) | ((u64)replay_get_u32(bytes + 4) << 32);
+}
+
+static f64
+replay_get_f64(u8* bytes) {
+    u64 bits = replay_get_u64(bytes);
+    f64 value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//Opens the replay at path and reads its header. Returns 0 if it can't be
+//read or isn't a replay this version can read, otherwise the file positioned
+//at the first record.
+static FILE*
+open_replay(const char* path, ReplayHeader* header) {
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        fprintf(stderr, "Can't read %s\n", path);
+        return 0;
+    }
+
+    u8 bytes[REPLAY_HEADER_SIZE];
+    if(!replay_read_bytes(file, bytes, REPLAY_HEADER_SIZE) || memcmp(bytes, "SNKR", 4) != 0) {
+        fprintf(stderr, "%s isn't a replay\n", path);
+        fclose(file);
+        return 0;
+    }
+    u32 version = (u32)bytes[4] | ((u32)bytes[5] << 8);
+    if(version != REPLAY_VERSION) {
+        fprintf(stderr, "%s is a version %u replay, this reads version %d\n", path, version, REPLAY_VERSION);
+        fclose(file);
+        return 0;
+    }
+
+    header->flags = (u32)bytes[6] | ((u32)bytes[7] << 8);
+    header->seed = replay_get_u64(bytes + 8);
+    header->game.grid_width = (i32)replay_get_u32(bytes + 16);
+    header->game.grid_height = (i32)replay_get_u32(bytes + 20);
+    header->game.planner = (i32)replay_get_u32(bytes + 24);
+    header->game.tail_safety = replay_get_u32(bytes + 28) != 0;
+    header->game.start_frame_time = replay_get_f64(bytes + 32);
+    header->game.min_frame_time = replay_get_f64(bytes + 40);
+    header->game.speed_up_rate = replay_get_f64(bytes + 48);
+    if(header->game.grid_width <= 0 || header->game.grid_height <= 0) {
+        fprintf(stderr, "%s has a %dx%d grid\n", path, header->game.grid_width, header->game.grid_height);
+        fclose(file);
+        return 0;
+    }
+    return file;
+}
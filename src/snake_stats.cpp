@@ -0,0 +1,75 @@
+//NOTE: Hot path counters, see SNAKE_STATS in snake.h. Each search counts
+//      into the SearchCounts kept with its own state, plan_path moves the
+//      counts of the planner it ran into the game's HotPathStats.
+
+inline i64
+stats_get_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (i64)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+#if SNAKE_STATS
+inline void
+clear_search_counts(SearchCounts* counts) {
+    memset(counts, 0, sizeof(*counts));
+}
+
+//Adds source to dest and clears it.
+inline void
+take_search_counts(SearchCounts* dest, SearchCounts* source) {
+    dest->push_count += source->push_count;
+    dest->pop_count += source->pop_count;
+    dest->decrease_key_count += source->decrease_key_count;
+    clear_search_counts(source);
+}
+
+static void
+clear_hot_path_stats(HotPathStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static void
+merge_hot_path_stats(HotPathStats* dest, HotPathStats* source) {
+    dest->ticks += source->ticks;
+    dest->plans += source->plans;
+    dest->nodes_expanded += source->nodes_expanded;
+    dest->nodes_pushed += source->nodes_pushed;
+    dest->heap_operations += source->heap_operations;
+    dest->path_length += source->path_length;
+    dest->plan_ns += source->plan_ns;
+    dest->move_ns += source->move_ns;
+    dest->frames += source->frames;
+    dest->render_ns += source->render_ns;
+}
+
+//Counts a plan that returned path_count cells, along with the work its
+//search left in counts.
+static void
+record_plan_stats(HotPathStats* stats, SearchCounts* counts, i32 path_count) {
+    ++stats->plans;
+    stats->path_length += path_count;
+    stats->nodes_expanded += counts->pop_count;
+    stats->nodes_pushed += counts->push_count;
+    stats->heap_operations += counts->push_count + counts->pop_count + counts->decrease_key_count;
+    clear_search_counts(counts);
+}
+
+//One line of averages, times per tick and per frame and search work per
+//plan. Leaves out the frames when nothing was rendered.
+static void
+format_hot_path_stats(char* buffer, size_t size, HotPathStats* stats) {
+    f64 ticks = (f64)max(stats->ticks, 1);
+    f64 plans = (f64)max(stats->plans, 1);
+    i32 length = snprintf(buffer, size, "tick: plan %.0fns move %.0fns, %.3f plans/tick | ",
+                          stats->plan_ns / ticks, stats->move_ns / ticks, stats->plans / ticks);
+    if(stats->frames > 0 && length >= 0 && (size_t)length < size) {
+        length += snprintf(buffer + length, size - length, "frame: render %.0fns | ",
+                           (f64)stats->render_ns / stats->frames);
+    }
+    if(length >= 0 && (size_t)length < size) {
+        snprintf(buffer + length, size - length, "plan: %.1f expanded %.1f pushed %.1f heap ops, path %.1f",
+                 stats->nodes_expanded / plans, stats->nodes_pushed / plans,
+                 stats->heap_operations / plans, stats->path_length / plans);
+    }
+}
+#endif
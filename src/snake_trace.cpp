@@ -0,0 +1,170 @@
+//NOTE: Writes spans as Chrome trace events, the JSON that chrome://tracing
+//      and ui.perfetto.dev open. Each thread that records a span gets its
+//      own ring the first time it does. Only that thread writes to the ring
+//      and only the writer thread reads it, so recording a span takes two
+//      clock reads and a store, without locks or I/O. The writer thread
+//      drains the rings every few milliseconds and appends to the file. A
+//      span that finds its ring full is dropped and counted instead of
+//      waiting for the writer.
+//
+//      There is one tracer per process, started before and stopped after
+//      the threads it traces. A thread that outlives a tracer still points
+//      at the ring it had, so each tracer gets a new generation and a thread
+//      only reuses its ring if it was registered with the current one.
+
+#define TRACE_RING_CAPACITY 16384 //Events, a power of two
+#define TRACE_WRITER_INTERVAL_MS 5
+
+struct TraceEvent {
+    const char* name; //Must stay valid until the tracer stops, use literals
+    i64 start_ns;
+    i64 duration_ns;
+};
+
+struct TraceRing {
+    TraceEvent events[TRACE_RING_CAPACITY];
+    std::atomic<u32> write_index; //Advanced by the owning thread
+    std::atomic<u32> read_index;  //Advanced by the writer thread
+    i64 dropped_count;
+    i32 thread_id;
+    TraceRing* next;
+};
+
+struct Tracer {
+    FILE* file;
+    i64 start_ns;
+    std::atomic<TraceRing*> rings; //Only ever prepended to while tracing
+    std::mutex register_mutex;
+    i32 thread_count;
+    std::atomic<b32> running;
+    std::thread writer;
+    i64 event_count;
+    u32 generation;
+};
+
+static std::atomic<Tracer*> active_tracer;
+static u32 last_trace_generation;
+static thread_local TraceRing* trace_ring;
+static thread_local u32 trace_ring_generation; //Of the tracer trace_ring belongs to
+
+static TraceRing*
+register_trace_ring(Tracer* tracer) {
+    TraceRing* ring = new TraceRing;
+    ring->write_index.store(0);
+    ring->read_index.store(0);
+    ring->dropped_count = 0;
+
+    std::lock_guard<std::mutex> lock(tracer->register_mutex);
+    ring->thread_id = ++tracer->thread_count;
+    ring->next = tracer->rings.load(std::memory_order_relaxed);
+    tracer->rings.store(ring, std::memory_order_release);
+    return ring;
+}
+
+//Returns the start time to pass to trace_end, 0 when not tracing.
+inline i64
+trace_begin() {
+    return active_tracer.load(std::memory_order_relaxed) ? stats_get_ns() : 0;
+}
+
+//Records a span called name from start_ns (see trace_begin) until now.
+inline void
+trace_end(const char* name, i64 start_ns) {
+    Tracer* tracer = active_tracer.load(std::memory_order_acquire);
+    if(!tracer) {
+        return;
+    }
+    i64 end_ns = stats_get_ns();
+    TraceRing* ring = trace_ring;
+    if(!ring || trace_ring_generation != tracer->generation) {
+        //The old ring, if any, was freed with its tracer
+        ring = trace_ring = register_trace_ring(tracer);
+        trace_ring_generation = tracer->generation;
+    }
+
+    u32 write_index = ring->write_index.load(std::memory_order_relaxed);
+    if(write_index - ring->read_index.load(std::memory_order_acquire) >= TRACE_RING_CAPACITY) {
+        ++ring->dropped_count;
+        return;
+    }
+    TraceEvent* event = &ring->events[write_index & (TRACE_RING_CAPACITY - 1)];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->duration_ns = end_ns - start_ns;
+    ring->write_index.store(write_index + 1, std::memory_order_release);
+}
+
+static void
+drain_trace_rings(Tracer* tracer) {
+    for(TraceRing* ring = tracer->rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        u32 read_index = ring->read_index.load(std::memory_order_relaxed);
+        u32 write_index = ring->write_index.load(std::memory_order_acquire);
+        for(; read_index != write_index; read_index++) {
+            TraceEvent* event = &ring->events[read_index & (TRACE_RING_CAPACITY - 1)];
+            fprintf(tracer->file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    tracer->event_count ? "," : "", event->name, ring->thread_id,
+                    (event->start_ns - tracer->start_ns) / 1000.0, event->duration_ns / 1000.0);
+            ++tracer->event_count;
+        }
+        ring->read_index.store(read_index, std::memory_order_release);
+    }
+}
+
+static void
+trace_writer_proc(Tracer* tracer) {
+    while(tracer->running.load(std::memory_order_acquire)) {
+        drain_trace_rings(tracer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_WRITER_INTERVAL_MS));
+    }
+}
+
+//Starts writing spans to path. Returns false if the file can't be created.
+static b32
+start_tracing(const char* path) {
+    assert(!active_tracer.load());
+    FILE* file = fopen(path, "w");
+    if(!file) {
+        fprintf(stderr, "Can't write %s\n", path);
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    Tracer* new_tracer = new Tracer;
+    new_tracer->file = file;
+    new_tracer->start_ns = stats_get_ns();
+    new_tracer->rings.store(0);
+    new_tracer->thread_count = 0;
+    new_tracer->event_count = 0;
+    new_tracer->generation = ++last_trace_generation;
+    new_tracer->running.store(true);
+    new_tracer->writer = std::thread(trace_writer_proc, new_tracer);
+    active_tracer.store(new_tracer, std::memory_order_release);
+    return true;
+}
+
+//Writes out what is left and closes the file. The traced threads must not
+//record spans anymore.
+static void
+stop_tracing() {
+    Tracer* old_tracer = active_tracer.exchange(0);
+    if(!old_tracer) {
+        return;
+    }
+    old_tracer->running.store(false, std::memory_order_release);
+    old_tracer->writer.join();
+    drain_trace_rings(old_tracer);
+
+    i64 dropped_count = 0;
+    for(TraceRing* ring = old_tracer->rings.load(); ring;) {
+        dropped_count += ring->dropped_count;
+        TraceRing* next = ring->next;
+        delete ring;
+        ring = next;
+    }
+    fprintf(old_tracer->file, "\n]}\n");
+    fclose(old_tracer->file);
+    if(dropped_count > 0) {
+        fprintf(stderr, "Trace dropped %lld spans, the writer couldn't keep up\n", (long long)dropped_count);
+    }
+    delete old_tracer;
+}